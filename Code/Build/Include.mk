@@ -57,16 +57,37 @@ BSCFLAGS = -D $(RV) \
 
 C_FILES  = $(REPO)/src_Top/C_Mems_Devices.c
 C_FILES += $(REPO)/src_Top/UART_model.c
+C_FILES += $(REPO)/src_Top/CLINT_model.c
+C_FILES += $(REPO)/src_Top/Elf_Loader.c
+C_FILES += $(REPO)/src_Top/Memhex_Loader.c
+C_FILES += $(REPO)/src_Top/Device_Registry.c
+C_FILES += $(REPO)/src_Top/BTrace.c
+C_FILES += $(REPO)/src_Top/PC_Profile.c
 C_FILES += $(REPO)/vendor/EDB/Dbg_Pkts.c
 C_FILES += $(REPO)/vendor/EDB/BDPI_RSPS_TCP_server.c
+C_FILES += $(REPO)/vendor/EDB/GDB_RSP.c
 
 # Only needed if we import C code
 BSC_C_FLAGS += -Xl -v  -Xc -O3  -Xc++ -O3
 
+# For the parallel memhex32 loader (and other C threads)
+BSC_C_FLAGS += -Xl -lpthread
+
 ifdef DRUM_RULES
 BSCFLAGS += -D DRUM_RULES
 endif
 
+# When the hart idles in a tight loop waiting for the timer, jump MTIME
+# to MTIMECMP (changes observed timing; off by default)
+ifdef IDLE_SKIP
+BSCFLAGS += -D IDLE_SKIP
+endif
+
+# zstd-compress the binary trace (+btrace) blocks (needs libzstd)
+ifdef BTRACE_ZSTD
+BSC_C_FLAGS += -Xc -DBTRACE_ZSTD  -Xc++ -DBTRACE_ZSTD  -Xl -lzstd
+endif
+
 # ----------------
 # bsc's directory search path
 
@@ -212,6 +233,6 @@ clean:
 
 .PHONY: full_clean
 full_clean: clean
-	rm -r -f  exe_*  verilog  log*  $(REPO)/src_Top/*.o  obj_dir_*
+	rm -r -f  exe_*  verilog  log*  trace.btr*  $(REPO)/src_Top/*.o  obj_dir_*
 
 # ****************************************************************
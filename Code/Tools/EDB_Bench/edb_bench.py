@@ -0,0 +1,184 @@
+#!/usr/bin/python3
+
+# ================================================================
+# Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved
+
+# ================================================================
+
+def print_usage (argv):
+    sys.stdout.write ("Usage:\n")
+    sys.stdout.write ("  {0}  [--port <n>] [--addr <a>] [--size <n>]".format (argv [0]))
+    sys.stdout.write (" [--block <n>] [--depth <n>]\n")
+    sys.stdout.write ("  Connects to a simulation started with +debug (the debugger stub),\n")
+    sys.stdout.write ("  and measures debugger memory-read latency and throughput:\n")
+    sys.stdout.write ("    scalar: 8-byte Dbg_to_CPU_RW packets (served by the CPU)\n")
+    sys.stdout.write ("    block:  Dbg_to_CPU_RW_BLOCK packets (served by the stub)\n")
+    sys.stdout.write ("  --port  <n>  TCP port of the stub              (default {:d})\n".format (dflt_port))
+    sys.stdout.write ("  --addr  <a>  Memory address to read from      (default 0x{:x})\n".format (dflt_addr))
+    sys.stdout.write ("  --size  <n>  Bytes to read for throughput     (default {:d})\n".format (dflt_size))
+    sys.stdout.write ("  --block <n>  Bytes per block packet           (default {:d})\n".format (dflt_block))
+    sys.stdout.write ("  --depth <n>  Max packets in flight            (default {:d})\n".format (dflt_depth))
+
+# ================================================================
+# Import standard libs
+
+import sys
+import socket
+import struct
+import time
+
+# ================================================================
+# Packet formats (see vendor/EDB/Dbg_Pkts.h)
+
+# Dbg_to_CPU_Pkt: pkt_type, rw_target, rw_op, rw_size, rw_addr, rw_wdata
+fmt_to_CPU   = "<IIIIQQ"
+# Dbg_from_CPU_Pkt: pkt_type, (padding), payload
+fmt_from_CPU = "<IIQ"
+
+size_to_CPU   = struct.calcsize (fmt_to_CPU)
+size_from_CPU = struct.calcsize (fmt_from_CPU)
+
+Dbg_to_CPU_RW       = 3
+Dbg_to_CPU_RW_BLOCK = 5
+
+Dbg_RW_MEM  = 3
+Dbg_RW_READ = 0
+Dbg_MEM_8B  = 3
+
+Dbg_from_CPU_RW_OK = 3
+
+DBG_BLOCK_MAX_B = 64 * 1024
+
+dflt_port  = 30000
+dflt_addr  = 0x80000000
+dflt_size  = 1024 * 1024
+dflt_block = DBG_BLOCK_MAX_B
+dflt_depth = 8
+
+n_latency_samples = 1000
+
+# ================================================================
+
+def main (argv = None):
+    if ("-h" in argv) or ("--help" in argv):
+        print_usage (argv)
+        return 0
+
+    args = {"--port": dflt_port, "--addr": dflt_addr, "--size": dflt_size,
+            "--block": dflt_block, "--depth": dflt_depth}
+    j = 1
+    while j < len (argv):
+        if (argv [j] not in args) or (j + 1 == len (argv)):
+            print_usage (argv)
+            return 1
+        args [argv [j]] = int (argv [j + 1], 0)
+        j += 2
+
+    block = args ["--block"]
+    if (block <= 0) or (block > DBG_BLOCK_MAX_B) or ((args ["--size"] % block) != 0):
+        sys.stdout.write ("ERROR: --block must be in 1..{:d} and divide --size\n".format (DBG_BLOCK_MAX_B))
+        return 1
+
+    sock = socket.create_connection (("127.0.0.1", args ["--port"]))
+    sock.setsockopt (socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    conn = Conn (sock)
+
+    addr  = args ["--addr"]
+    size  = args ["--size"]
+    depth = args ["--depth"]
+
+    sys.stdout.write ("Latency (one packet in flight; {:d} samples)\n".format (n_latency_samples))
+    report_latency ("scalar 8B", conn, lambda: conn.rd_scalar (addr))
+    report_latency ("block 8B",  conn, lambda: conn.rd_block (addr, 8))
+
+    sys.stdout.write ("Throughput (read {:d} bytes; up to {:d} packets in flight)\n".format (size, depth))
+    (secs, data_s) = read_pipelined (conn, addr, size, 8, depth, False)
+    report_throughput ("scalar 8B", size, secs)
+    (secs, data_b) = read_pipelined (conn, addr, size, block, depth, True)
+    report_throughput ("block {:d}B".format (block), size, secs)
+
+    if data_s != data_b:
+        sys.stdout.write ("ERROR: scalar and block reads returned different data\n")
+        return 1
+    sys.stdout.write ("Scalar and block reads returned identical data\n")
+    return 0
+
+# ================================================================
+# Connection to the stub
+
+class Conn:
+    def __init__ (self, sock):
+        self.sock = sock
+
+    def recv_exact (self, n):
+        chunks = []
+        while n > 0:
+            b = self.sock.recv (min (n, 1 << 20))
+            if not b:
+                raise EOFError ("connection closed by stub")
+            chunks.append (b)
+            n -= len (b)
+        return b"".join (chunks)
+
+    def send_rd_scalar (self, addr):
+        self.sock.sendall (struct.pack (fmt_to_CPU, Dbg_to_CPU_RW, Dbg_RW_MEM,
+                                        Dbg_RW_READ, Dbg_MEM_8B, addr, 0))
+
+    def send_rd_block (self, addr, n):
+        self.sock.sendall (struct.pack (fmt_to_CPU, Dbg_to_CPU_RW_BLOCK, Dbg_RW_MEM,
+                                        Dbg_RW_READ, 0, addr, n))
+
+    # Returns the data of a scalar (is_block False) or block response
+    def recv_rsp (self, is_block):
+        (pkt_type, _, payload) = struct.unpack (fmt_from_CPU, self.recv_exact (size_from_CPU))
+        if pkt_type != Dbg_from_CPU_RW_OK:
+            raise RuntimeError ("error response (pkt_type {:d})".format (pkt_type))
+        if is_block:
+            return self.recv_exact (payload)
+        return struct.pack ("<Q", payload)
+
+    def rd_scalar (self, addr):
+        self.send_rd_scalar (addr)
+        return self.recv_rsp (False)
+
+    def rd_block (self, addr, n):
+        self.send_rd_block (addr, n)
+        return self.recv_rsp (True)
+
+# ================================================================
+
+def report_latency (name, conn, fn):
+    samples = []
+    for j in range (n_latency_samples):
+        t0 = time.perf_counter ()
+        fn ()
+        samples.append (time.perf_counter () - t0)
+    samples.sort ()
+    med = samples [len (samples) // 2] * 1e6
+    p99 = samples [(len (samples) * 99) // 100] * 1e6
+    sys.stdout.write ("  {:<12s} median {:8.1f} us   p99 {:8.1f} us\n".format (name, med, p99))
+
+def read_pipelined (conn, addr, size, chunk, depth, is_block):
+    n_pkts  = size // chunk
+    n_sent  = 0
+    data    = []
+    t0      = time.perf_counter ()
+    while len (data) < n_pkts:
+        while (n_sent < n_pkts) and (n_sent - len (data) < depth):
+            a = addr + (n_sent * chunk)
+            if is_block:
+                conn.send_rd_block (a, chunk)
+            else:
+                conn.send_rd_scalar (a)
+            n_sent += 1
+        data.append (conn.recv_rsp (is_block))
+    return (time.perf_counter () - t0, b"".join (data))
+
+def report_throughput (name, size, secs):
+    sys.stdout.write ("  {:<12s} {:8.3f} s   {:10.2f} MB/s\n".format (name, secs, size / secs / 1e6))
+
+# ================================================================
+# For non-interactive invocations, call main() and use its return value
+# as the exit code.
+if __name__ == '__main__':
+  sys.exit (main (sys.argv))
@@ -0,0 +1,195 @@
+#!/usr/bin/python3
+
+# ================================================================
+# Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved
+
+# ================================================================
+
+def print_usage (argv):
+    sys.stdout.write ("Usage:\n")
+    sys.stdout.write ("  {0}  [--port <n>] [--addr <a>] [--samples <n>]\n".format (argv [0]))
+    sys.stdout.write ("  Connects to a simulation started with +debug (the debugger stub),\n")
+    sys.stdout.write ("  speaking GDB's Remote Serial Protocol (as 'target remote' would),\n")
+    sys.stdout.write ("  checks basic commands, and measures round-trip latency of:\n")
+    sys.stdout.write ("    'g' (all registers), 'p' (one register), 'm'/'x' (memory reads\n")
+    sys.stdout.write ("    of 64 and 4096 bytes), 'X' (binary memory write), and single-step.\n")
+    sys.stdout.write ("  The CPU is left running on exit (detach).\n")
+    sys.stdout.write ("  --port    <n>  TCP port of the stub          (default {:d})\n".format (dflt_port))
+    sys.stdout.write ("  --addr    <a>  Memory address for m/x/X       (default 0x{:x})\n".format (dflt_addr))
+    sys.stdout.write ("  --samples <n>  Samples per measurement        (default {:d})\n".format (dflt_samples))
+
+# ================================================================
+# Import standard libs
+
+import sys
+import socket
+import time
+
+# ================================================================
+
+dflt_port    = 30000
+dflt_addr    = 0x80000000
+dflt_samples = 1000
+
+# ================================================================
+
+def main (argv = None):
+    if ("-h" in argv) or ("--help" in argv):
+        print_usage (argv)
+        return 0
+
+    args = {"--port": dflt_port, "--addr": dflt_addr, "--samples": dflt_samples}
+    j = 1
+    while j < len (argv):
+        if (argv [j] not in args) or (j + 1 == len (argv)):
+            print_usage (argv)
+            return 1
+        args [argv [j]] = int (argv [j + 1], 0)
+        j += 2
+
+    addr    = args ["--addr"]
+    samples = args ["--samples"]
+
+    sock = socket.create_connection (("127.0.0.1", args ["--port"]))
+    sock.setsockopt (socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    conn = RSP_Conn (sock)
+
+    # Handshake, as GDB does it
+    features = conn.cmd (b"qSupported:multiprocess+;swbreak+;hwbreak+;xmlRegisters=riscv")
+    sys.stdout.write ("qSupported: {:s}\n".format (features.decode ()))
+    check (conn.cmd (b"QStartNoAckMode") == b"OK", "QStartNoAckMode")
+    conn.no_ack = True
+    stop = conn.cmd (b"?")
+    sys.stdout.write ("Stop reply: {:s}\n".format (stop.decode ()))
+    xml = conn.qxfer (b"qXfer:features:read:target.xml")
+    xlen = 64 if b"riscv:rv64" in xml else 32
+    sys.stdout.write ("Target description: {:d} bytes, RV{:d}\n".format (len (xml), xlen))
+
+    # Sanity checks
+    regs = conn.cmd (b"g")
+    check (len (regs) == 33 * xlen // 4, "'g' reply length")
+    pc_hex = regs [32 * xlen // 4:]
+    check (conn.cmd (b"p20") == pc_hex, "'p20' (pc) agrees with 'g'")
+
+    m_hex = conn.cmd ("m{:x},40".format (addr).encode ())
+    x_bin = conn.cmd ("x{:x},40".format (addr).encode ())
+    check ((x_bin [:1] == b"b") and (x_bin [1:] == bytes.fromhex (m_hex.decode ())),
+           "'m' and 'x' agree")
+
+    # Binary write with bytes that need escaping; read back; restore
+    special = bytes ([0x23, 0x24, 0x7d, 0x2a, 0x00, 0xff, 0x03, 0x2b])
+    check (conn.cmd (b"X" + "{:x},{:x}:".format (addr, len (special)).encode () + escape (special))
+           == b"OK", "'X' write")
+    check (conn.cmd ("m{:x},{:x}".format (addr, len (special)).encode ())
+           == special.hex ().encode (), "'X' write read back")
+    check (conn.cmd ("M{:x},40:".format (addr).encode () + m_hex) == b"OK", "'M' restore")
+
+    sys.stdout.write ("Latency ({:d} samples)\n".format (samples))
+    report_latency ("g",       samples, lambda: conn.cmd (b"g"))
+    report_latency ("p20",     samples, lambda: conn.cmd (b"p20"))
+    report_latency ("m 64B",   samples, lambda: conn.cmd ("m{:x},40".format (addr).encode ()))
+    report_latency ("x 64B",   samples, lambda: conn.cmd ("x{:x},40".format (addr).encode ()))
+    report_latency ("m 4KB",   samples, lambda: conn.cmd ("m{:x},1000".format (addr).encode ()))
+    report_latency ("x 4KB",   samples, lambda: conn.cmd ("x{:x},1000".format (addr).encode ()))
+    x_cmd = b"X" + "{:x},40:".format (addr).encode () + escape (bytes.fromhex (m_hex.decode ()))
+    report_latency ("X 64B",   samples, lambda: conn.cmd (x_cmd))
+    report_latency ("step",    samples, lambda: conn.cmd (b"vCont;s:1"))
+
+    check (conn.cmd (b"D") == b"OK", "detach")
+    sock.close ()
+    return 0
+
+# ================================================================
+# RSP connection
+
+class RSP_Conn:
+    def __init__ (self, sock):
+        self.sock   = sock
+        self.no_ack = False
+        self.buf    = b""
+
+    def recv_byte (self):
+        if not self.buf:
+            self.buf = self.sock.recv (1 << 20)
+            if not self.buf:
+                raise EOFError ("connection closed by stub")
+        b = self.buf [:1]
+        self.buf = self.buf [1:]
+        return b
+
+    # Send a command; return the reply's data (with checksum verified)
+    def cmd (self, data):
+        self.sock.sendall (b"$" + data + b"#" + "{:02x}".format (sum (data) & 0xFF).encode ())
+        if not self.no_ack:
+            check (self.recv_byte () == b"+", "ack")
+        while self.recv_byte () != b"$":
+            pass
+        j = self.buf.find (b"#")
+        while (j < 0) or (len (self.buf) < j + 3):
+            chunk = self.sock.recv (1 << 20)
+            if not chunk:
+                raise EOFError ("connection closed by stub")
+            self.buf += chunk
+            j = self.buf.find (b"#")
+        reply    = self.buf [:j]
+        chksum   = int (self.buf [j + 1: j + 3], 16)
+        self.buf = self.buf [j + 3:]
+        check (chksum == (sum (reply) & 0xFF), "reply checksum")
+        if not self.no_ack:
+            self.sock.sendall (b"+")
+        return unescape (reply)
+
+    def qxfer (self, prefix):
+        data = b""
+        while True:
+            reply = self.cmd (prefix + ":{:x},{:x}".format (len (data), 0x1000).encode ())
+            data += reply [1:]
+            if reply [:1] == b"l":
+                return data
+
+# ================================================================
+
+def escape (data):
+    out = bytearray ()
+    for b in data:
+        if b in (0x23, 0x24, 0x7d, 0x2a):
+            out += bytes ([0x7d, b ^ 0x20])
+        else:
+            out.append (b)
+    return bytes (out)
+
+def unescape (data):
+    if 0x7d not in data:
+        return data
+    out = bytearray ()
+    j = 0
+    while j < len (data):
+        if (data [j] == 0x7d) and (j + 1 < len (data)):
+            out.append (data [j + 1] ^ 0x20)
+            j += 2
+        else:
+            out.append (data [j])
+            j += 1
+    return bytes (out)
+
+def check (cond, what):
+    if not cond:
+        sys.stdout.write ("ERROR: check failed: {:s}\n".format (what))
+        sys.exit (1)
+
+def report_latency (name, samples, fn):
+    ts = []
+    for j in range (samples):
+        t0 = time.perf_counter ()
+        fn ()
+        ts.append (time.perf_counter () - t0)
+    ts.sort ()
+    med = ts [len (ts) // 2] * 1e6
+    p99 = ts [(len (ts) * 99) // 100] * 1e6
+    sys.stdout.write ("  {:<8s} median {:8.1f} us   p99 {:8.1f} us\n".format (name, med, p99))
+
+# ================================================================
+# For non-interactive invocations, call main() and use its return value
+# as the exit code.
+if __name__ == '__main__':
+  sys.exit (main (sys.argv))
@@ -10,6 +10,7 @@ def print_usage (argv):
     sys.stdout.write ("Usage:\n")
     sys.stdout.write ("  {0}  <log.txt>  <inum1  <inum2>\n".format (argv [0]))
     sys.stdout.write ("  where <log.txt> is a log file from Fife or Drum\n")
+    sys.stdout.write ("                    (or a binary trace.btr, from +btrace)\n")
     sys.stdout.write ("        <inum1>   is an instruction-number\n")
     sys.stdout.write ("        <inum2>   is an instruction-number\n")
     sys.stdout.write ("  Creates two output files:")
@@ -32,6 +33,7 @@ import fileinput
 # Import our libs
 
 import disasm_lib
+import btrace_lib
 
 # ================================================================
 
@@ -54,10 +56,9 @@ def main (argv = None):
         sys.stdout.write ("ERROR: inum2 should be > inum1\n");
         return 1;
 
-    f_in = open (in_filename, "r")
     sys.stdout.write ("INFO: Input file is {:s}\n".format (in_filename))
 
-    (min_tick, max_tick, events) = read_trace_file (f_in, inum1, inum2)
+    (min_tick, max_tick, events) = read_trace_file (in_filename, inum1, inum2)
     sys.stdout.write ("INFO: tick range is [{:0d}..{:0d}]\n".format (min_tick, max_tick))
 
     # ----------------
@@ -152,30 +153,13 @@ def emit_instr (f_csv, inum, tick_offset, events):
 # Read file discarding items with inums outside the (inum,inum+n) rant
 # return (min_tick, max_tick, events)    where events are sorted by inum
 
-def read_trace_file (f_in, inum1, inum2):
+def read_trace_file (in_filename, inum1, inum2):
     # Process file
-    line_num   = 0
     min_tick   = 0
     max_tick   = 0
 
     events = []
-    while True:
-        line = f_in.readline()
-        if line == "": break
-        line_num += 1
-        words = line.split()
-        # Ignore lines that don't begin with "Trace"
-        if words [0] != "Trace": continue
-
-        if (debug):
-            sys.stdout.write ("Line {:d} '{:s}'\n".format(line_num, line.strip()))
-
-        tick  = int (words [1])
-        inum  = int (words [2])
-        pc    = int (words [3], 16)
-        instr = int (words [4], 16)
-        stage = words [5]
-
+    for (tick, inum, pc, instr, stage) in read_trace_records (in_filename, inum1):
         if (inum < inum1): continue
         if ((inum2 + 20) < inum): break
 
@@ -191,6 +175,31 @@ def read_trace_file (f_in, inum1, inum2):
 
     return (min_tick, max_tick, events)
 
+# Generator of (tick, inum, pc, instr, stage) from the "Trace" lines of
+# a text log, or from a binary trace (skipping, using its index, to
+# near the first event for inum1)
+
+def read_trace_records (in_filename, inum1):
+    if btrace_lib.is_btrace_file (in_filename):
+        yield from btrace_lib.read_events_from_inum (in_filename, inum1)
+        return
+
+    f_in = open (in_filename, "r")
+    line_num = 0
+    while True:
+        line = f_in.readline()
+        if line == "": break
+        line_num += 1
+        words = line.split()
+        # Ignore lines that don't begin with "Trace"
+        if (len (words) < 6) or (words [0] != "Trace"): continue
+
+        if (debug):
+            sys.stdout.write ("Line {:d} '{:s}'\n".format(line_num, line.strip()))
+
+        yield (int (words [1]), int (words [2]), int (words [3], 16), int (words [4], 16), words [5])
+    f_in.close ()
+
 # ****************************************************************
 # ****************************************************************
 # ****************************************************************
@@ -0,0 +1,246 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Extract a window of instructions [inum1..inum2] from a binary trace
+// (trace.btr, from +btrace) as text "Trace" lines, as in log.txt.
+
+// The trace is mmap'ed, and its index (trace.btr.idx) is used to
+// decompress only the blocks that hold events of those instructions,
+// so the time taken does not depend on the size of the trace.  Without
+// a (valid) index, every block is scanned.
+
+// Build (add -DBTRACE_ZSTD ... -lzstd for compressed traces):
+//     g++ -O2 -o btrace_extract btrace_extract.cpp
+
+// ****************************************************************
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef BTRACE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "../../src_Top/BTrace.h"
+
+// ****************************************************************
+
+static
+void print_usage (const char *argv0)
+{
+    fprintf (stdout, "Usage:\n");
+    fprintf (stdout, "  %s  <trace.btr>  <inum1>  <inum2>  [<out.txt>]\n", argv0);
+    fprintf (stdout, "  Writes the 'Trace' lines (as in log.txt) of the events of instructions\n");
+    fprintf (stdout, "  <inum1> thru <inum2>, in cycle order, to <out.txt> (default: stdout).\n");
+    fprintf (stdout, "  Uses <trace.btr>.idx, if present, to read only the blocks needed.\n");
+}
+
+// A file, mmap'ed read-only
+
+struct Mapped_File {
+    const uint8_t *p      = nullptr;
+    size_t         size_B = 0;
+
+    bool open (const char *filename) {
+	int fd = ::open (filename, O_RDONLY);
+	if (fd < 0)
+	    return false;
+	struct stat st;
+	if ((fstat (fd, & st) != 0) || (st.st_size == 0)) {
+	    close (fd);
+	    return false;
+	}
+	void *m = mmap (nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (m == MAP_FAILED)
+	    return false;
+	p      = (const uint8_t *) m;
+	size_B = st.st_size;
+	return true;
+    }
+};
+
+// ****************************************************************
+
+struct Extractor {
+    Mapped_File               trace;
+    std::vector <std::string> stage_labels;
+    std::vector <BTrace_Event> events;    // decompressed block
+    uint64_t                  inum1, inum2;
+    FILE                     *fo;
+    uint64_t                  n_blocks_read = 0;
+    uint64_t                  n_lines       = 0;
+
+    // Decompress the block at 'offset' into 'events'; returns the offset of the next block
+    uint64_t read_block (const uint64_t offset) {
+	if (offset + sizeof (BTrace_Block_Header) > trace.size_B) {
+	    fprintf (stderr, "ERROR: truncated block header at offset %" PRIu64 "\n", offset);
+	    exit (1);
+	}
+	BTrace_Block_Header hdr;
+	memcpy (& hdr, trace.p + offset, sizeof (hdr));
+	const uint64_t payload_offset = offset + sizeof (hdr);
+	if (payload_offset + hdr.stored_B > trace.size_B) {
+	    fprintf (stderr, "ERROR: truncated block at offset %" PRIu64 "\n", offset);
+	    exit (1);
+	}
+	const uint8_t *payload = trace.p + payload_offset;
+
+	events.resize (hdr.n_events);
+	const size_t raw_B = hdr.n_events * sizeof (BTrace_Event);
+	if (hdr.codec == BTRACE_CODEC_RAW) {
+	    memcpy (events.data (), payload, raw_B);
+	}
+	else if (hdr.codec == BTRACE_CODEC_ZSTD) {
+#ifdef BTRACE_ZSTD
+	    size_t n = ZSTD_decompress (events.data (), raw_B, payload, hdr.stored_B);
+	    if (ZSTD_isError (n) || (n != raw_B)) {
+		fprintf (stderr, "ERROR: bad zstd block at offset %" PRIu64 "\n", offset);
+		exit (1);
+	    }
+#else
+	    fprintf (stderr, "ERROR: trace is zstd-compressed; rebuild with -DBTRACE_ZSTD ... -lzstd\n");
+	    exit (1);
+#endif
+	}
+	else {
+	    fprintf (stderr, "ERROR: unknown codec %0d at offset %" PRIu64 "\n", hdr.codec, offset);
+	    exit (1);
+	}
+	n_blocks_read++;
+	return payload_offset + hdr.stored_B;
+    }
+
+    // Print events of the current block in [inum1..inum2]; note stage definitions
+    void emit_block () {
+	for (const BTrace_Event &e : events) {
+	    if (e.stage == BTRACE_STAGE_DEF) {
+		char label [BTRACE_MAX_LABEL_LEN + 1];
+		memcpy (label, & e, BTRACE_MAX_LABEL_LEN);
+		label [BTRACE_MAX_LABEL_LEN] = 0;
+		if (stage_labels.size () <= e.instr)
+		    stage_labels.resize (e.instr + 1);
+		stage_labels [e.instr] = label;
+	    }
+	    else if ((inum1 <= e.inum) && (e.inum <= inum2)) {
+		const char *label = ((e.stage < stage_labels.size ())
+				     ? stage_labels [e.stage].c_str () : "?");
+		fprintf (fo, "Trace %" PRIu64 " %" PRIu64 " %08" PRIx64 " %08x %s\n",
+			 e.cycle, e.inum, e.pc, e.instr, label);
+		n_lines++;
+	    }
+	}
+    }
+
+    // Using the index
+    bool extract_indexed (const char *index_filename) {
+	Mapped_File idx;
+	if (! idx.open (index_filename))
+	    return false;
+
+	BTrace_Index_Header hdr;
+	if (idx.size_B < sizeof (hdr))
+	    return false;
+	memcpy (& hdr, idx.p, sizeof (hdr));
+	if ((memcmp (hdr.magic, BTRACE_INDEX_MAGIC, sizeof (hdr.magic)) != 0)
+	    || (hdr.version != BTRACE_INDEX_VERSION)
+	    || (hdr.entry_size_B != sizeof (BTrace_Index_Entry))) {
+	    fprintf (stderr, "WARNING: %s is not a usable index; ignoring it\n", index_filename);
+	    return false;
+	}
+
+	// The index is appended to as the trace is written; a partial
+	// entry at the end is ignored
+	const uint64_t n_entries = (idx.size_B - sizeof (hdr)) / sizeof (BTrace_Index_Entry);
+	const uint8_t *entries   = idx.p + sizeof (hdr);
+	for (uint64_t j = 0; j < n_entries; j++) {
+	    BTrace_Index_Entry e;
+	    memcpy (& e, entries + j * sizeof (e), sizeof (e));
+	    if (e.kind == BTRACE_INDEX_STAGE) {
+		char label [BTRACE_MAX_LABEL_LEN + 1];
+		memcpy (label, & e, BTRACE_MAX_LABEL_LEN);
+		label [BTRACE_MAX_LABEL_LEN] = 0;
+		if (stage_labels.size () <= e.n_events)
+		    stage_labels.resize (e.n_events + 1);
+		stage_labels [e.n_events] = label;
+	    }
+	    else if ((e.min_inum <= inum2) && (e.max_inum >= inum1)) {
+		read_block (e.offset);
+		emit_block ();
+	    }
+	}
+	return true;
+    }
+
+    // Without the index: every block
+    void extract_scan () {
+	uint64_t offset = sizeof (BTrace_File_Header);
+	while (offset < trace.size_B) {
+	    offset = read_block (offset);
+	    emit_block ();
+	}
+    }
+};
+
+// ****************************************************************
+
+int main (int argc, char *argv [])
+{
+    if ((argc < 4) || (argc > 5)) {
+	print_usage (argv [0]);
+	return ((argc == 2) && ((strcmp (argv [1], "-h") == 0) || (strcmp (argv [1], "--help") == 0))) ? 0 : 1;
+    }
+
+    Extractor x;
+    x.inum1 = strtoull (argv [2], nullptr, 0);
+    x.inum2 = strtoull (argv [3], nullptr, 0);
+    x.fo    = stdout;
+    if (x.inum1 > x.inum2) {
+	fprintf (stderr, "ERROR: inum2 should be >= inum1\n");
+	return 1;
+    }
+
+    if (! x.trace.open (argv [1])) {
+	fprintf (stderr, "ERROR: unable to open/mmap trace file: %s\n", argv [1]);
+	return 1;
+    }
+    BTrace_File_Header fhdr;
+    if (x.trace.size_B >= sizeof (fhdr))
+	memcpy (& fhdr, x.trace.p, sizeof (fhdr));
+    if ((x.trace.size_B < sizeof (fhdr))
+	|| (memcmp (fhdr.magic, BTRACE_MAGIC, sizeof (fhdr.magic)) != 0)
+	|| (fhdr.event_size_B != sizeof (BTrace_Event))) {
+	fprintf (stderr, "ERROR: not a binary trace file: %s\n", argv [1]);
+	return 1;
+    }
+
+    if (argc == 5) {
+	x.fo = fopen (argv [4], "w");
+	if (x.fo == nullptr) {
+	    fprintf (stderr, "ERROR: unable to open output file: %s\n", argv [4]);
+	    return 1;
+	}
+    }
+
+    std::string index_filename = std::string (argv [1]) + ".idx";
+    if (! x.extract_indexed (index_filename.c_str ())) {
+	fprintf (stderr, "WARNING: no usable index; scanning the whole trace\n");
+	x.extract_scan ();
+    }
+
+    if (x.fo != stdout)
+	fclose (x.fo);
+    fprintf (stderr, "INFO: %0" PRIu64 " lines, from %0" PRIu64 " blocks\n",
+	     x.n_lines, x.n_blocks_read);
+    return 0;
+}
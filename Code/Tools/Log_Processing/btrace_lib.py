@@ -0,0 +1,179 @@
+#!/usr/bin/python3
+
+# Library to read binary pipeline traces (trace.btr, from +btrace)
+# Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved
+# File format: see Code/src_Top/BTrace.h
+
+# ================================================================
+# Import standard libs
+
+import sys
+import os
+import struct
+
+# ================================================================
+
+BTRACE_MAGIC      = b"BTRACE01"
+BTRACE_CODEC_RAW  = 0
+BTRACE_CODEC_ZSTD = 1
+BTRACE_STAGE_DEF  = 0xFFFF
+
+fmt_file_header  = "<8sII"       # magic, version, event_size_B
+fmt_block_header = "<IIII"       # codec, n_events, stored_B, reserved
+fmt_event        = "<QQQIHH"     # cycle, inum, pc, instr, stage, reserved
+
+BTRACE_INDEX_MAGIC   = b"BTRIDX01"
+BTRACE_INDEX_VERSION = 2
+BTRACE_INDEX_BLOCK   = 0
+BTRACE_INDEX_STAGE   = 1
+BTRACE_MAX_LABEL_LEN = 23
+
+fmt_index_header = "<8sII"       # magic, version, entry_size_B
+fmt_index_entry  = "<QQQQII"     # offset, min_inum, max_inum, first_cycle, n_events, kind
+
+size_file_header  = struct.calcsize (fmt_file_header)
+size_block_header = struct.calcsize (fmt_block_header)
+size_event        = struct.calcsize (fmt_event)
+size_index_header = struct.calcsize (fmt_index_header)
+size_index_entry  = struct.calcsize (fmt_index_entry)
+
+# ================================================================
+# Is this file a binary trace (as opposed to a text log.txt)?
+
+def is_btrace_file (filename):
+    with open (filename, "rb") as f:
+        return f.read (len (BTRACE_MAGIC)) == BTRACE_MAGIC
+
+# ================================================================
+# Generator of events, in file order (by cycle):
+#     (cycle, inum, pc, instr, stage_label)
+# Reads one block at a time, so memory use is independent of file size.
+
+def read_events (filename, offset = None, stages = None):
+    if stages is None:
+        stages = {}
+    for (cycle, inum, pc, instr, stage, _) in read_raw_events (filename, offset):
+        if stage == BTRACE_STAGE_DEF:
+            name = struct.pack ("<QQQ", cycle, inum, pc).split (b"\0") [0]
+            stages [instr] = name.decode ()
+        else:
+            yield (cycle, inum, pc, instr, stages [stage])
+
+# Generator of raw event tuples (including stage definitions)
+
+def read_raw_events (filename, offset = None):
+    for payload in read_blocks (filename, offset):
+        yield from struct.iter_unpack (fmt_event, payload)
+
+# ----------------
+# Like read_events(), but starting (using the index file, if any) at
+# the first block that may have events of instructions >= inum.
+# Events of earlier instructions may still be returned.
+
+def read_events_from_inum (filename, inum):
+    index = read_index (filename)
+    if index is None:
+        return read_events (filename)
+    (stages, entries) = index
+    for (offset, min_inum, max_inum, _, _, _) in entries:
+        if (min_inum <= max_inum) and (max_inum >= inum):
+            return read_events (filename, offset, stages)
+    return iter (())
+
+# Returns (stages, block index entries), or None if there is no valid
+# index.  The index is appended to as the trace is written, so it may
+# end in a partial entry (ignored), and covers only the blocks written
+# before it was last flushed.
+
+def read_index (filename):
+    try:
+        with open (filename + ".idx", "rb") as f:
+            data = f.read ()
+    except OSError:
+        return None
+    if len (data) < size_index_header:
+        return None
+    (magic, version, entry_size_B) = struct.unpack_from (fmt_index_header, data)
+    if ((magic != BTRACE_INDEX_MAGIC)
+        or (version != BTRACE_INDEX_VERSION)
+        or (entry_size_B != size_index_entry)):
+        sys.stderr.write ("WARNING: {:s}.idx is not a usable index; ignoring it\n".format (filename))
+        return None
+    trace_size_B = os.path.getsize (filename)
+    n_entries    = (len (data) - size_index_header) // size_index_entry
+    stages  = {}
+    entries = []
+    for j in range (n_entries):
+        off = size_index_header + j * size_index_entry
+        entry = struct.unpack_from (fmt_index_entry, data, off)
+        (offset, _, _, _, n_events, kind) = entry
+        if kind == BTRACE_INDEX_STAGE:
+            stages [n_events] = data [off: off + BTRACE_MAX_LABEL_LEN + 1].split (b"\0") [0].decode ()
+        elif offset + size_block_header <= trace_size_B:
+            entries.append (entry)
+        else:
+            sys.stderr.write ("WARNING: {:s}.idx does not match the trace; ignoring it\n".format (filename))
+            return None
+    return (stages, entries)
+
+# ----------------
+# Generator of decompressed block payloads, from the block at 'offset'
+# (default: the first block)
+
+def read_blocks (filename, offset = None):
+    dctx = None
+    with open (filename, "rb") as f:
+        (magic, version, event_size_B) = struct.unpack (fmt_file_header,
+                                                        f.read (size_file_header))
+        if magic != BTRACE_MAGIC:
+            raise ValueError ("{:s}: not a binary trace file".format (filename))
+        if event_size_B != size_event:
+            raise ValueError ("{:s}: unexpected event size {:d}".format (filename, event_size_B))
+        if offset is not None:
+            f.seek (offset)
+
+        while True:
+            hdr = f.read (size_block_header)
+            if len (hdr) == 0:
+                return
+            if len (hdr) < size_block_header:
+                sys.stderr.write ("WARNING: {:s}: truncated block header\n".format (filename))
+                return
+            (codec, n_events, stored_B, _) = struct.unpack (fmt_block_header, hdr)
+            payload = f.read (stored_B)
+            if len (payload) < stored_B:
+                sys.stderr.write ("WARNING: {:s}: truncated block\n".format (filename))
+                return
+            if codec == BTRACE_CODEC_ZSTD:
+                if dctx is None:
+                    dctx = zstd_decompressor ()
+                payload = dctx.decompress (payload, max_output_size = n_events * size_event)
+            elif codec != BTRACE_CODEC_RAW:
+                raise ValueError ("{:s}: unknown block codec {:d}".format (filename, codec))
+            yield payload
+
+def zstd_decompressor ():
+    try:
+        import zstandard
+    except ImportError:
+        sys.stderr.write ("ERROR: trace is zstd-compressed; please 'pip install zstandard'\n")
+        sys.exit (1)
+    return zstandard.ZstdDecompressor ()
+
+# ================================================================
+# Text 'Trace' line, as in log.txt (without the ad-hoc info)
+
+def event_to_text (event):
+    (cycle, inum, pc, instr, label) = event
+    return "Trace {:d} {:d} {:08x} {:08x} {:s}".format (cycle, inum, pc, instr, label)
+
+# ================================================================
+# Invoked directly, print the trace as text 'Trace' lines
+
+if __name__ == '__main__':
+    if (len (sys.argv) != 2) or (sys.argv [1] in ("-h", "--help")):
+        sys.stdout.write ("Usage:  {0}  <trace.btr>\n".format (sys.argv [0]))
+        sys.stdout.write ("  Prints the binary trace as 'Trace' lines, as in log.txt\n")
+        sys.exit (0)
+    for e in read_events (sys.argv [1]):
+        sys.stdout.write (event_to_text (e) + "\n")
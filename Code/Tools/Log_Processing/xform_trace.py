@@ -12,12 +12,14 @@ import os
 # Import our libs
 
 import disasm_lib
+import btrace_lib
 
 # ================================================================
 
 def print_usage (fo, argv):
     fo.write ("Usage:  {0}  <inputfile.txt>  <foo>\n".format (argv [0]))
     fo.write ("  <inputfile.txt> is trace file from Drum or Fife\n")
+    fo.write ("                  (or a binary trace.btr, from +btrace)\n")
     fo.write ("  Writes two files, <foo>.txt and <foo>_aux.txt\n")
     fo.write ("  For each line L in inputfile, let (b,L') = xform (x,L)\n")
     fo.write ("    If b, write L' to foo.txt and L'+L to foo_aux.txt\n")
@@ -43,7 +45,10 @@ def main (argv):
     sys.stdout.write ("INFO: out file_2: '{:s}'\n".format (outfilename_2))
 
     try:
-        fi = open (infilename, "r")
+        if btrace_lib.is_btrace_file (infilename):
+            fi = BTrace_Lines (infilename)
+        else:
+            fi = open (infilename, "r")
     except:
         sys.stdout.write ("ERROR: could not open input file: {:s}\n"
                           .format (infilename))
@@ -90,6 +95,20 @@ def main (argv):
     fo_2.close()
     return 0
 
+# ================================================================
+# A binary trace, read like a text file of "Trace" lines
+
+class BTrace_Lines:
+    def __init__ (self, filename):
+        self.events = btrace_lib.read_events (filename)
+
+    def readline (self):
+        e = next (self.events, None)
+        return "" if e is None else (btrace_lib.event_to_text (e) + "\n")
+
+    def close (self):
+        pass
+
 # ================================================================
 # This function processes each line
 
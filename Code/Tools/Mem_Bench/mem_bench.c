@@ -0,0 +1,593 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Micro-benchmarks for the C memory model (src_Top/C_Mems_Devices.c
+// and friends), linked with the same C files and C flags as the
+// Bluesim/Verilator executables (see README.txt and Makefile).
+
+// The driver calls the model only through its BDPI entry points, via
+// function pointers (as from the separately compiled simulator), so
+// nothing is inlined into the driver.
+
+// ****************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../../src_Top/Memhex_Loader.h"
+
+// ****************************************************************
+// BDPI entry points of the memory model
+
+extern
+void c_mems_devices_init (uint64_t addr_base, uint64_t size_B);
+
+extern
+void c_mems_devices_req_rsp (uint8_t        *result_p,
+			     const uint64_t  inum,
+			     const uint32_t  req_type,
+			     const uint32_t  req_size_code,
+			     const uint64_t  addr,
+			     const uint32_t  client,
+			     uint8_t        *wdata_p);
+
+// Called through this, so that the compiler cannot see into it
+typedef void (*Req_Rsp_Fn) (uint8_t *, const uint64_t, const uint32_t, const uint32_t,
+			    const uint64_t, const uint32_t, uint8_t *);
+
+static Req_Rsp_Fn volatile req_rsp_fn = c_mems_devices_req_rsp;
+
+// ----------------
+// Encodings (same as in C_Mems_Devices.c)
+
+#define funct5_FETCH    0x06
+#define funct5_LOAD     0x1E
+#define funct5_STORE    0x1F
+#define funct5_LR       0x02
+#define funct5_SC       0x03
+#define funct5_AMOSWAP  0x01
+#define funct5_AMOADD   0x00
+#define funct5_AMOMAX   0x14
+#define funct5_AMOMINU  0x18
+
+#define MEM_1B 0
+#define MEM_2B 1
+#define MEM_4B 2
+#define MEM_8B 3
+
+#define MEM_RSP_OK  0
+
+#define CLIENT_IMEM  0
+#define CLIENT_DMEM  1
+#define CLIENT_MMIO  2
+
+#define RESULT_SIZE_B  12
+
+// ----------------
+// Simulated system (as in Top.bsv)
+
+#define ADDR_BASE_MEM  0x80000000
+#define SIZE_B_MEM     0x10000000
+
+#define ADDR_UART_LSR  (0x60100000 + (5 * 4))
+
+// ****************************************************************
+// Timing
+
+static
+double now_secs (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, & ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+// Host clock ticks (TSC on x86; else nanoseconds)
+
+static inline
+uint64_t now_ticks (void)
+{
+#if defined (__x86_64__) || defined (__i386__)
+    return __rdtsc ();
+#else
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, & ts);
+    return (((uint64_t) ts.tv_sec) * 1000000000) + ts.tv_nsec;
+#endif
+}
+
+#if defined (__x86_64__) || defined (__i386__)
+static const char ticks_name [] = "TSC cycles";
+#else
+static const char ticks_name [] = "ns";
+#endif
+
+// ****************************************************************
+// Checks
+
+static
+void check_status (const uint8_t *result_p, const char *what)
+{
+    uint32_t status;
+    memcpy (& status, result_p, 4);
+    if (status != MEM_RSP_OK) {
+	fprintf (stdout, "ERROR: mem_bench: %s: status %0d\n", what, status);
+	exit (1);
+    }
+}
+
+// ****************************************************************
+// 'access': cycles per c_mems_devices_req_rsp() call for aligned RAM
+// accesses (the fast path in C_Mems_Devices.c)
+
+// Each kind runs N calls over ACCESS_N precomputed (size, address)
+// pairs, aligned, in 1 MiB of memory: sequential 4-byte addresses, or
+// random sizes and addresses (so the host mispredicts branches on the
+// size).  'null call' is the cost of calling an empty function the same
+// way, i.e., the driver's share.  Each is the best of ACCESS_REPS runs,
+// since on a shared host single runs vary widely.
+
+#define ACCESS_N     (1 << 16)
+#define ACCESS_REPS  5
+
+typedef struct {
+    uint32_t  req_type;
+    uint32_t  req_size_code;
+    uint64_t  addr;
+} Access;
+
+typedef struct {
+    const char *name;
+    uint32_t    req_type;         // 0 for mixed LOAD/STORE; LR for LR/SC pairs
+    uint32_t    req_size_code;    // ignored if random
+    bool        random;
+    uint32_t    client;
+} Access_Kind;
+
+static
+void null_req_rsp (uint8_t        *result_p,
+		   const uint64_t  inum,
+		   const uint32_t  req_type,
+		   const uint32_t  req_size_code,
+		   const uint64_t  addr,
+		   const uint32_t  client,
+		   uint8_t        *wdata_p)
+{
+    const uint32_t status = MEM_RSP_OK;
+    memcpy (result_p, & status, 4);
+}
+
+static
+void mk_accesses (Access *accesses, const Access_Kind *kind_p)
+{
+    uint64_t x = 0x9E3779B97F4A7C15ULL;    // xorshift state
+    for (uint64_t j = 0; j < ACCESS_N; j++) {
+	x ^= x << 13;  x ^= x >> 7;  x ^= x << 17;
+	const uint32_t size_code = (kind_p->random ? (x & 0x3) : kind_p->req_size_code);
+	uint32_t       type      = kind_p->req_type;
+	uint64_t       offset    = (j << size_code);
+	if (type == 0)    // mixed LOAD/STORE
+	    type = (((x >> 2) & 0x3) == 0) ? funct5_STORE : funct5_LOAD;
+	else if (type == funct5_LR) {    // LR/SC pairs to the same address
+	    type   = (((j & 1) == 0) ? funct5_LR : funct5_SC);
+	    offset = ((j >> 1) << size_code);
+	}
+	if (kind_p->random)
+	    offset = (x >> 8) & (~ ((1ULL << size_code) - 1));
+	accesses [j].req_type      = type;
+	accesses [j].req_size_code = size_code;
+	accesses [j].addr          = ADDR_BASE_MEM + (offset & 0xFFFFF);
+    }
+}
+
+static
+double time_accesses (Req_Rsp_Fn fn, const Access *accesses, const uint32_t client,
+		      const uint64_t n)
+{
+    uint8_t  result [RESULT_SIZE_B];
+    uint64_t wdata [2] = { 0x0123456789ABCDEFULL, 0 };
+
+    uint64_t best = UINT64_MAX;
+    for (int rep = 0; rep < ACCESS_REPS; rep++) {
+	const uint64_t k0 = now_ticks ();
+	for (uint64_t j = 0; j < n; j++) {
+	    const Access *a = & (accesses [j % ACCESS_N]);
+	    fn (result, j, a->req_type, a->req_size_code, a->addr, client, (uint8_t *) wdata);
+	}
+	const uint64_t k1 = now_ticks ();
+	check_status (result, "access");
+	if ((k1 - k0) < best)
+	    best = k1 - k0;
+    }
+    return ((double) best) / n;
+}
+
+static
+void run_access_kinds (const char *title, const Access_Kind *kinds, const int n_kinds,
+		       const uint64_t n)
+{
+    Access *accesses = malloc (ACCESS_N * sizeof (Access));
+    if (accesses == NULL) {
+	fprintf (stdout, "ERROR: mem_bench: out of memory\n");
+	exit (1);
+    }
+
+    fprintf (stdout, "%s: %0" PRId64 " calls per kind (best of %0d)\n",
+	     title, n, ACCESS_REPS);
+
+    const Access_Kind null_kind = { "null call", funct5_LOAD, MEM_4B, false, CLIENT_DMEM };
+    mk_accesses (accesses, & null_kind);
+    fprintf (stdout, "    %-28s %6.1f %s/call\n", null_kind.name,
+	     time_accesses (null_req_rsp, accesses, null_kind.client, n), ticks_name);
+
+    for (int k = 0; k < n_kinds; k++) {
+	mk_accesses (accesses, & (kinds [k]));
+	fprintf (stdout, "    %-28s %6.1f %s/call\n", kinds [k].name,
+		 time_accesses (req_rsp_fn, accesses, kinds [k].client, n), ticks_name);
+    }
+    free (accesses);
+}
+
+static
+void bench_access (const uint64_t n)
+{
+    const Access_Kind kinds [] = {
+	{ "FETCH 4B seq",              funct5_FETCH, MEM_4B, false, CLIENT_IMEM },
+	{ "LOAD 4B seq",               funct5_LOAD,  MEM_4B, false, CLIENT_DMEM },
+	{ "STORE 4B seq",              funct5_STORE, MEM_4B, false, CLIENT_DMEM },
+	{ "LOAD 1/2/4/8B random",      funct5_LOAD,  0,      true,  CLIENT_DMEM },
+	{ "STORE 1/2/4/8B random",     funct5_STORE, 0,      true,  CLIENT_DMEM },
+	{ "LOAD/STORE (3:1) random",   0,            0,      true,  CLIENT_DMEM }
+    };
+    run_access_kinds ("access", kinds, sizeof (kinds) / sizeof (kinds [0]), n);
+}
+
+// ****************************************************************
+// 'amo': cycles per call for AMOs and LR/SC (c_access_mem_AMO()), at
+// sequential addresses; an LR/SC pair is two calls.
+
+static
+void bench_amo (const uint64_t n)
+{
+    const Access_Kind kinds [] = {
+	{ "AMOADD.W",                  funct5_AMOADD,  MEM_4B, false, CLIENT_DMEM },
+	{ "AMOADD.D",                  funct5_AMOADD,  MEM_8B, false, CLIENT_DMEM },
+	{ "AMOSWAP.W",                 funct5_AMOSWAP, MEM_4B, false, CLIENT_DMEM },
+	{ "AMOMAX.W (CAS loop)",       funct5_AMOMAX,  MEM_4B, false, CLIENT_DMEM },
+	{ "AMOMINU.D (CAS loop)",      funct5_AMOMINU, MEM_8B, false, CLIENT_DMEM },
+	{ "LR.W/SC.W (per call)",      funct5_LR,      MEM_4B, false, CLIENT_DMEM },
+	{ "STORE 4B seq (reference)",  funct5_STORE,   MEM_4B, false, CLIENT_DMEM }
+    };
+    run_access_kinds ("amo", kinds, sizeof (kinds) / sizeof (kinds [0]), n);
+}
+
+// ****************************************************************
+// 'batch': scalar vs. batched BDPI calls, i.e., one call per request
+// vs. one call per cycle carrying the heads of all request FIFOs
+
+// A synthetic request stream, one simulated cycle at a time: a FETCH
+// from IMem every cycle (sequential, looping over 16 KiB of code), a
+// LOAD from DMem every 3rd cycle and a STORE every 8th (in 64 KiB of
+// data), and an MMIO read of the UART's LSR every 1000th.
+// The scalar path makes one call per request (as rules rl_IMem_req_rsp,
+// rl_DMem_req_rsp and rl_MMIO_req_rsp in Mems_Devices.bsv do); the
+// batched path makes one call per cycle to batch_req_rsp() below, with
+// the heads of all N_BATCH FIFOs (IMem, DMem, MMIO, Dbg) packed into
+// fixed-size records.
+
+#define N_BATCH  4
+
+typedef struct {
+    uint64_t  inum;
+    uint64_t  addr;
+    uint64_t  wdata;
+    uint32_t  req_type;
+    uint8_t   req_size_code;
+    uint8_t   client;
+    uint8_t   valid;
+    uint8_t   pad;
+} Mem_Req_Packed;
+
+// The batched BDPI entry point, as it would be in C_Mems_Devices.c:
+// serves the valid slots of reqs_p, each with c_mems_devices_req_rsp(),
+// leaving the results of invalid slots untouched.
+// (Here the calls cross files; in the model they could be inlined.)
+
+static __attribute__ ((noinline))
+void batch_req_rsp (uint8_t        *results_p,
+		    const uint32_t  n_reqs,
+		    const uint8_t  *reqs_p)
+{
+    for (uint32_t j = 0; j < n_reqs; j++) {
+	const uint8_t *req_p = reqs_p + (j * sizeof (Mem_Req_Packed));
+	if (req_p [offsetof (Mem_Req_Packed, valid)] == 0) continue;
+
+	Mem_Req_Packed req;
+	memcpy (& req, req_p, sizeof (Mem_Req_Packed));
+	c_mems_devices_req_rsp (results_p + (j * RESULT_SIZE_B),
+				req.inum,
+				req.req_type,
+				req.req_size_code,
+				req.addr,
+				req.client,
+				(uint8_t *) (& req.wdata));
+    }
+}
+
+typedef void (*Req_Rsp_Batch_Fn) (uint8_t *, const uint32_t, const uint8_t *);
+
+static Req_Rsp_Batch_Fn volatile req_rsp_batch_fn = batch_req_rsp;
+
+static
+uint32_t cycle_reqs (const uint64_t cycle, Mem_Req_Packed reqs [N_BATCH])
+{
+    memset (reqs, 0, N_BATCH * sizeof (Mem_Req_Packed));
+
+    const uint64_t pc = ADDR_BASE_MEM + ((cycle * 4) & 0x3FFF);
+    reqs [0] = (Mem_Req_Packed) { .inum = cycle, .addr = pc, .req_type = funct5_FETCH,
+				  .req_size_code = MEM_4B, .client = CLIENT_IMEM, .valid = 1 };
+    uint32_t n = 1;
+
+    const uint64_t data_addr = ADDR_BASE_MEM + 0x100000 + (((cycle * 28) & 0xFFFF) & (~ 0x3ULL));
+    if ((cycle % 8) == 0) {
+	reqs [1] = (Mem_Req_Packed) { .inum = cycle, .addr = data_addr, .wdata = cycle,
+				      .req_type = funct5_STORE, .req_size_code = MEM_4B,
+				      .client = CLIENT_DMEM, .valid = 1 };
+	n++;
+    }
+    else if ((cycle % 3) == 0) {
+	reqs [1] = (Mem_Req_Packed) { .inum = cycle, .addr = data_addr,
+				      .req_type = funct5_LOAD, .req_size_code = MEM_4B,
+				      .client = CLIENT_DMEM, .valid = 1 };
+	n++;
+    }
+
+    if ((cycle % 1000) == 999) {
+	reqs [2] = (Mem_Req_Packed) { .inum = cycle, .addr = ADDR_UART_LSR,
+				      .req_type = funct5_LOAD, .req_size_code = MEM_4B,
+				      .client = CLIENT_MMIO, .valid = 1 };
+	n++;
+    }
+    return n;
+}
+
+// The stream repeats every STREAM_N cycles (precomputed, so both paths
+// time only the calls and their packing/unpacking).
+
+#define STREAM_N  (1 << 16)
+
+static
+void bench_batch (const uint64_t n_cycles)
+{
+    Mem_Req_Packed *stream = malloc (STREAM_N * N_BATCH * sizeof (Mem_Req_Packed));
+    if (stream == NULL) {
+	fprintf (stdout, "ERROR: mem_bench: out of memory\n");
+	exit (1);
+    }
+    uint64_t n_reqs_stream = 0;
+    for (uint64_t c = 0; c < STREAM_N; c++)
+	n_reqs_stream += cycle_reqs (c, & (stream [c * N_BATCH]));
+    const double reqs_per_cycle = ((double) n_reqs_stream) / STREAM_N;
+
+    // ---------------- Scalar: one call per request
+    uint64_t n_calls_scalar = 0;
+    double   t0             = now_secs ();
+    uint64_t k0             = now_ticks ();
+    for (uint64_t c = 0; c < n_cycles; c++) {
+	const Mem_Req_Packed *reqs = & (stream [(c % STREAM_N) * N_BATCH]);
+	for (uint32_t j = 0; j < N_BATCH; j++) {
+	    if (reqs [j].valid == 0) continue;
+	    uint8_t  result [RESULT_SIZE_B];
+	    uint64_t wdata [2] = { reqs [j].wdata, 0 };
+	    req_rsp_fn (result, reqs [j].inum, reqs [j].req_type, reqs [j].req_size_code,
+			reqs [j].addr, reqs [j].client, (uint8_t *) wdata);
+	    check_status (result, "scalar");
+	    n_calls_scalar++;
+	}
+    }
+    const uint64_t k_scalar = now_ticks () - k0;
+    const double   s_scalar = now_secs () - t0;
+
+    // ---------------- Batched: one call per cycle
+    uint64_t n_calls_batch = 0;
+    t0 = now_secs ();
+    k0 = now_ticks ();
+    for (uint64_t c = 0; c < n_cycles; c++) {
+	uint8_t packed  [N_BATCH * sizeof (Mem_Req_Packed)];
+	uint8_t results [N_BATCH * RESULT_SIZE_B];
+	memcpy (packed, & (stream [(c % STREAM_N) * N_BATCH]), sizeof (packed));
+	req_rsp_batch_fn (results, N_BATCH, packed);
+	n_calls_batch++;
+	for (uint32_t j = 0; j < N_BATCH; j++) {
+	    if (packed [(j * sizeof (Mem_Req_Packed)) + offsetof (Mem_Req_Packed, valid)] == 0)
+		continue;
+	    check_status (& (results [j * RESULT_SIZE_B]), "batch");
+	}
+    }
+    const uint64_t k_batch = now_ticks () - k0;
+    const double   s_batch = now_secs () - t0;
+
+    free (stream);
+
+    fprintf (stdout, "batch: %0" PRId64 " cycles, %0.2f requests per cycle\n",
+	     n_cycles, reqs_per_cycle);
+    fprintf (stdout, "    scalar:  %0" PRId64 " calls, %6.1f %s/cycle, %6.1f Mcycles/s\n",
+	     n_calls_scalar, ((double) k_scalar) / n_cycles, ticks_name,
+	     (n_cycles / s_scalar) * 1e-6);
+    fprintf (stdout, "    batched: %0" PRId64 " calls, %6.1f %s/cycle, %6.1f Mcycles/s\n",
+	     n_calls_batch, ((double) k_batch) / n_cycles, ticks_name,
+	     (n_cycles / s_batch) * 1e-6);
+
+    // Each call saved must save this much BSV-to-C crossing cost
+    // (outside this bench: the simulator's per-call overhead) to win
+    const double calls_saved = ((double) (n_calls_scalar - n_calls_batch)) / n_cycles;
+    const double extra       = ((double) k_batch - (double) k_scalar) / n_cycles;
+    if ((calls_saved > 0) && (extra > 0))
+	fprintf (stdout, "    break-even: batching wins if a BDPI call costs > %0.1f %s\n",
+		 extra / calls_saved, ticks_name);
+}
+
+// ****************************************************************
+// 'memhex': the serial vs. the parallel memhex32 loader (Memhex_Loader.c)
+// Loads the same file with each into its own memory array, checks
+// that the two arrays are byte-identical, and reports MB/s (best of
+// MEMHEX_REPS loads).  Without --file, generates a file of N random
+// words in runs of 4096, at scattered '@' addresses.
+
+#define MEMHEX_REPS  3
+
+static
+void memhex_gen (const char *filename, const uint64_t n_words)
+{
+    FILE *fp = fopen (filename, "w");
+    if (fp == NULL) {
+	fprintf (stdout, "ERROR: mem_bench: unable to create %s\n", filename);
+	exit (1);
+    }
+    const uint64_t size_words = SIZE_B_MEM / 4;
+    uint64_t x = 0x9E3779B97F4A7C15ULL;    // xorshift state
+    for (uint64_t j = 0; j < n_words; j++) {
+	x ^= x << 13;  x ^= x >> 7;  x ^= x << 17;
+	if ((j % 4096) == 0)
+	    fprintf (fp, "@%08" PRIx64 "\n",
+		     (ADDR_BASE_MEM / 4) + (((j * 3) % (size_words - 4096)) & (~ 0xFFFULL)));
+	fprintf (fp, "%08" PRIx32 "\n", (uint32_t) (x >> 32));
+    }
+    fclose (fp);
+}
+
+static
+uint8_t *mk_array (void)
+{
+    void *p = mmap (NULL, SIZE_B_MEM, (PROT_READ | PROT_WRITE),
+		    (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE), -1, 0);
+    if (p == MAP_FAILED) {
+	fprintf (stdout, "ERROR: mem_bench: unable to mmap memory array\n");
+	exit (1);
+    }
+    return (uint8_t *) p;
+}
+
+static
+double time_memhex (const char *filename, uint8_t *array, const int n_threads,
+		    uint64_t *n_bytes_p)
+{
+    double best = 1e30;
+    for (int rep = 0; rep < MEMHEX_REPS; rep++) {
+	const double t0 = now_secs ();
+	const int rc = load_memhex32 (filename, array, ADDR_BASE_MEM, SIZE_B_MEM,
+				      n_threads, 0, n_bytes_p);
+	const double secs = now_secs () - t0;
+	if ((rc != 0) || (*n_bytes_p == 0)) {
+	    fprintf (stdout, "ERROR: mem_bench: unable to load %s\n", filename);
+	    exit (1);
+	}
+	if (secs < best)
+	    best = secs;
+    }
+    return best;
+}
+
+static
+void bench_memhex (const char *filename, const uint64_t n_words, const int n_threads)
+{
+    char gen_filename [] = "mem_bench_gen.memhex32";
+    if (filename == NULL) {
+	memhex_gen (gen_filename, n_words);
+	filename = gen_filename;
+    }
+
+    uint8_t *array_serial   = mk_array ();
+    uint8_t *array_parallel = mk_array ();
+
+    uint64_t     n_bytes;
+    const double s_serial   = time_memhex (filename, array_serial,   1,         & n_bytes);
+    const double s_parallel = time_memhex (filename, array_parallel, n_threads, & n_bytes);
+
+    const bool same = (memcmp (array_serial, array_parallel, SIZE_B_MEM) == 0);
+
+    fprintf (stdout, "memhex: %s, %0" PRId64 " bytes (best of %0d)\n",
+	     filename, n_bytes, MEMHEX_REPS);
+    fprintf (stdout, "    serial:               %8.3f ms, %7.1f MB/s\n",
+	     s_serial * 1e3, (n_bytes / s_serial) * 1e-6);
+    fprintf (stdout, "    parallel (%2d threads): %8.3f ms, %7.1f MB/s\n",
+	     n_threads, s_parallel * 1e3, (n_bytes / s_parallel) * 1e-6);
+    fprintf (stdout, "    memory contents: %s\n", (same ? "identical" : "DIFFERENT"));
+
+    munmap (array_serial,   SIZE_B_MEM);
+    munmap (array_parallel, SIZE_B_MEM);
+    if (filename == gen_filename)
+	unlink (gen_filename);
+    if (! same)
+	exit (1);
+}
+
+// ****************************************************************
+
+static
+void print_usage (const char *argv0)
+{
+    fprintf (stdout, "Usage:  %s  <bench>  [--n <n>]  [--file <f>]  [--threads <t>]\n", argv0);
+    fprintf (stdout, "  <bench>  access   cycles per aligned RAM FETCH/LOAD/STORE\n");
+    fprintf (stdout, "           amo      cycles per AMO, and per LR/SC call\n");
+    fprintf (stdout, "           batch    scalar vs. batched req/rsp calls\n");
+    fprintf (stdout, "           memhex   serial vs. parallel memhex32 loader (--file, --threads)\n");
+    fprintf (stdout, "  --n <n>  number of cycles/requests, or words in the generated\n");
+    fprintf (stdout, "           memhex32 file if no --file (default 10000000)\n");
+    fprintf (stdout, "  --threads <t>  threads for the parallel loader (default 4)\n");
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc < 2) {
+	print_usage (argv [0]);
+	return 1;
+    }
+    const char *bench = argv [1];
+
+    uint64_t    n         = 10000000;
+    const char *filename  = NULL;
+    int         n_threads = 4;
+    for (int j = 2; j < argc; j++) {
+	if ((strcmp (argv [j], "--n") == 0) && ((j + 1) < argc))
+	    n = strtoull (argv [++j], NULL, 0);
+	else if ((strcmp (argv [j], "--file") == 0) && ((j + 1) < argc))
+	    filename = argv [++j];
+	else if ((strcmp (argv [j], "--threads") == 0) && ((j + 1) < argc))
+	    n_threads = atoi (argv [++j]);
+	else {
+	    print_usage (argv [0]);
+	    return 1;
+	}
+    }
+
+    c_mems_devices_init (ADDR_BASE_MEM, SIZE_B_MEM);
+
+    if (strcmp (bench, "access") == 0)
+	bench_access (n);
+    else if (strcmp (bench, "amo") == 0)
+	bench_amo (n);
+    else if (strcmp (bench, "batch") == 0)
+	bench_batch (n);
+    else if (strcmp (bench, "memhex") == 0)
+	bench_memhex (filename, n, n_threads);
+    else {
+	print_usage (argv [0]);
+	return 1;
+    }
+    return 0;
+}
+
+// ****************************************************************
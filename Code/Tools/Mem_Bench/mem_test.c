@@ -0,0 +1,295 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Self-checking test of the C memory model's AMOs and LR/SC
+// (c_access_mem_AMO() in src_Top/C_Mems_Devices.c), through its BDPI
+// entry point c_mems_devices_req_rsp(), as the CPU sees them.
+// Prints each failing check, and exits with status 1 if any failed.
+
+// ****************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdbool.h>
+
+// ****************************************************************
+// BDPI entry points of the memory model
+
+extern
+void c_mems_devices_init (uint64_t addr_base, uint64_t size_B);
+
+extern
+void c_mems_devices_req_rsp (uint8_t        *result_p,
+			     const uint64_t  inum,
+			     const uint32_t  req_type,
+			     const uint32_t  req_size_code,
+			     const uint64_t  addr,
+			     const uint32_t  client,
+			     uint8_t        *wdata_p);
+
+// ----------------
+// Encodings (same as in C_Mems_Devices.c)
+
+#define funct5_LOAD     0x1E
+#define funct5_STORE    0x1F
+#define funct5_LR       0x02
+#define funct5_SC       0x03
+#define funct5_AMOSWAP  0x01
+#define funct5_AMOADD   0x00
+#define funct5_AMOXOR   0x04
+#define funct5_AMOAND   0x0C
+#define funct5_AMOOR    0x08
+#define funct5_AMOMIN   0x10
+#define funct5_AMOMAX   0x14
+#define funct5_AMOMINU  0x18
+#define funct5_AMOMAXU  0x1C
+
+#define MEM_1B 0
+#define MEM_2B 1
+#define MEM_4B 2
+#define MEM_8B 3
+
+#define MEM_RSP_OK          0
+#define MEM_RSP_ERR         2
+
+#define CLIENT_DMEM  1
+
+#define ADDR_BASE_MEM  0x80000000
+#define SIZE_B_MEM     0x10000000
+
+// Test data, at a 64-byte (reservation granule) boundary
+#define A  (ADDR_BASE_MEM + 0x100000)
+
+// ****************************************************************
+
+static int n_checks   = 0;
+static int n_failures = 0;
+
+static uint64_t inum = 0;
+
+// Returns status; *rdata_p gets the response data
+
+static
+uint32_t req (const uint32_t req_type, const uint32_t size_code, const uint64_t addr,
+	      const uint64_t wdata, uint64_t *rdata_p)
+{
+    uint8_t  result [12];
+    uint64_t wdata_buf [2] = { wdata, 0 };
+    c_mems_devices_req_rsp (result, inum++, req_type, size_code, addr, CLIENT_DMEM,
+			    (uint8_t *) wdata_buf);
+    uint32_t status;
+    memcpy (& status, result, 4);
+    memcpy (rdata_p, & (result [4]), 8);
+    return status;
+}
+
+static
+void check (const char *what, const uint64_t actual, const uint64_t expected)
+{
+    n_checks++;
+    if (actual != expected) {
+	n_failures++;
+	fprintf (stdout, "FAIL: %s: got 0x%016" PRIx64 ", expected 0x%016" PRIx64 "\n",
+		 what, actual, expected);
+    }
+}
+
+// Request that must succeed; returns its response data
+
+static
+uint64_t req_ok (const char *what, const uint32_t req_type, const uint32_t size_code,
+		 const uint64_t addr, const uint64_t wdata)
+{
+    uint64_t rdata;
+    const uint32_t status = req (req_type, size_code, addr, wdata, & rdata);
+    check (what, status, MEM_RSP_OK);
+    return rdata;
+}
+
+static
+void store (const uint32_t size_code, const uint64_t addr, const uint64_t wdata)
+{
+    req_ok ("store", funct5_STORE, size_code, addr, wdata);
+}
+
+static
+uint64_t load (const uint32_t size_code, const uint64_t addr)
+{
+    return req_ok ("load", funct5_LOAD, size_code, addr, 0);
+}
+
+// ----------------
+// One AMO: checks the returned (old) value and the new memory value
+
+static
+void check_amo (const char *what, const uint32_t req_type, const uint32_t size_code,
+		const uint64_t mem_init, const uint64_t wdata,
+		const uint64_t expected_rdata, const uint64_t expected_mem)
+{
+    char buf [128];
+
+    store (size_code, A, mem_init);
+    const uint64_t rdata = req_ok (what, req_type, size_code, A, wdata);
+    snprintf (buf, sizeof (buf), "%s: rdata", what);
+    check (buf, rdata, expected_rdata);
+    snprintf (buf, sizeof (buf), "%s: mem", what);
+    check (buf, load (size_code, A), expected_mem);
+}
+
+// ****************************************************************
+
+static
+void test_amo_w_sign_extension (void)
+{
+    // Old values with bit 31 set are returned sign-extended
+    check_amo ("AMOADD.W +ve",  funct5_AMOADD,  MEM_4B, 0x7FFFFFFF, 1,
+	       0x000000007FFFFFFFULL, 0x0000000080000000ULL);
+    check_amo ("AMOADD.W -ve",  funct5_AMOADD,  MEM_4B, 0x80000000, 1,
+	       0xFFFFFFFF80000000ULL, 0x0000000080000001ULL);
+    check_amo ("AMOSWAP.W",     funct5_AMOSWAP, MEM_4B, 0xFFFFFFFE, 5,
+	       0xFFFFFFFFFFFFFFFEULL, 5);
+    check_amo ("AMOXOR.W",      funct5_AMOXOR,  MEM_4B, 0xF0F0F0F0, 0xFFFFFFFF,
+	       0xFFFFFFFFF0F0F0F0ULL, 0x0F0F0F0F);
+    check_amo ("AMOAND.W",      funct5_AMOAND,  MEM_4B, 0x8000FFFF, 0xFFFF0000,
+	       0xFFFFFFFF8000FFFFULL, 0x80000000);
+    check_amo ("AMOOR.W",       funct5_AMOOR,   MEM_4B, 0x80000000, 0x1,
+	       0xFFFFFFFF80000000ULL, 0x80000001);
+
+    // .W touches only its 4 bytes
+    store (MEM_8B, A, 0x1111111122222222ULL);
+    req_ok ("AMOADD.W lower", funct5_AMOADD, MEM_4B, A, 1);
+    check ("AMOADD.W lower: upper word unchanged", load (MEM_8B, A), 0x1111111122222223ULL);
+
+    // .D results are not truncated
+    check_amo ("AMOADD.D",      funct5_AMOADD,  MEM_8B, 0xFFFFFFFF80000000ULL, 0x100000000ULL,
+	       0xFFFFFFFF80000000ULL, 0x0000000080000000ULL);
+}
+
+static
+void test_amo_min_max (void)
+{
+    // Signed vs. unsigned comparison; rdata is always the old value
+    check_amo ("AMOMIN.W",      funct5_AMOMIN,  MEM_4B, 0xFFFFFFFB, 3,    // -5 vs 3
+	       0xFFFFFFFFFFFFFFFBULL, 0xFFFFFFFB);
+    check_amo ("AMOMINU.W",     funct5_AMOMINU, MEM_4B, 0xFFFFFFFB, 3,
+	       0xFFFFFFFFFFFFFFFBULL, 3);
+    check_amo ("AMOMAX.W",      funct5_AMOMAX,  MEM_4B, 3, 0xFFFFFFF6,    // 3 vs -10
+	       3, 3);
+    check_amo ("AMOMAXU.W",     funct5_AMOMAXU, MEM_4B, 3, 0xFFFFFFF6,
+	       3, 0xFFFFFFF6);
+    check_amo ("AMOMIN.W eq",   funct5_AMOMIN,  MEM_4B, 7, 7, 7, 7);
+
+    check_amo ("AMOMIN.D",      funct5_AMOMIN,  MEM_8B, 0x8000000000000000ULL, 1,
+	       0x8000000000000000ULL, 0x8000000000000000ULL);
+    check_amo ("AMOMINU.D",     funct5_AMOMINU, MEM_8B, 0x8000000000000000ULL, 1,
+	       0x8000000000000000ULL, 1);
+    check_amo ("AMOMAX.D",      funct5_AMOMAX,  MEM_8B, 0x8000000000000000ULL, 1,
+	       0x8000000000000000ULL, 1);
+    check_amo ("AMOMAXU.D",     funct5_AMOMAXU, MEM_8B, 1, 0x8000000000000000ULL,
+	       1, 0x8000000000000000ULL);
+}
+
+// ----------------
+// LR/SC.  SC returns 0 on success, 1 on failure.
+
+static
+void test_lr_sc (void)
+{
+    uint64_t rdata;
+
+    // Success
+    store (MEM_4B, A, 0x80000010);
+    check ("LR.W rdata", req_ok ("LR.W", funct5_LR, MEM_4B, A, 0), 0xFFFFFFFF80000010ULL);
+    check ("SC.W ok", req_ok ("SC.W", funct5_SC, MEM_4B, A, 42), 0);
+    check ("SC.W ok: mem", load (MEM_4B, A), 42);
+
+    store (MEM_8B, A + 8, 1);
+    req_ok ("LR.D", funct5_LR, MEM_8B, A + 8, 0);
+    check ("SC.D ok", req_ok ("SC.D", funct5_SC, MEM_8B, A + 8, 2), 0);
+    check ("SC.D ok: mem", load (MEM_8B, A + 8), 2);
+
+    // Failure: the reservation was consumed by the previous SC
+    check ("SC.W without LR", req_ok ("SC.W", funct5_SC, MEM_4B, A, 43), 1);
+    check ("SC.W without LR: mem", load (MEM_4B, A), 42);
+
+    // Failure: different address, different size
+    store (MEM_4B, A + 4, 0);
+    req_ok ("LR.W", funct5_LR, MEM_4B, A, 0);
+    check ("SC.W other addr", req_ok ("SC.W", funct5_SC, MEM_4B, A + 4, 44), 1);
+    check ("SC.W other addr: mem", load (MEM_4B, A + 4), 0);
+
+    store (MEM_8B, A, 0);
+    req_ok ("LR.W", funct5_LR, MEM_4B, A, 0);
+    check ("SC.D after LR.W", req_ok ("SC.D", funct5_SC, MEM_8B, A, 45), 1);
+    check ("SC.D after LR.W: mem", load (MEM_8B, A), 0);
+
+    // A failed SC also clears the reservation
+    req_ok ("LR.W", funct5_LR, MEM_4B, A, 0);
+    req_ok ("SC.W", funct5_SC, MEM_4B, A + 4, 46);
+    check ("SC.W after failed SC", req_ok ("SC.W", funct5_SC, MEM_4B, A, 47), 1);
+
+    // Unsupported sizes
+    check ("LR.B status", req (funct5_LR, MEM_1B, A, 0, & rdata), MEM_RSP_ERR);
+    check ("AMOADD.H status", req (funct5_AMOADD, MEM_2B, A, 0, & rdata), MEM_RSP_ERR);
+}
+
+static
+void test_reservation_cancel (void)
+{
+    // Stores of any size anywhere in the reserved 64-byte granule
+    const uint32_t sizes [4] = { MEM_1B, MEM_2B, MEM_4B, MEM_8B };
+    for (int j = 0; j < 4; j++) {
+	store (MEM_4B, A, 100);
+	req_ok ("LR.W", funct5_LR, MEM_4B, A, 0);
+	store (sizes [j], A + 56, 0);    // same granule, other word
+	check ("SC.W after store in granule", req_ok ("SC.W", funct5_SC, MEM_4B, A, 101), 1);
+	check ("SC.W after store in granule: mem", load (MEM_4B, A), 100);
+    }
+
+    // A store of the same value (ABA) also cancels
+    req_ok ("LR.W", funct5_LR, MEM_4B, A, 0);
+    store (MEM_4B, A, 100);
+    check ("SC.W after same-value store", req_ok ("SC.W", funct5_SC, MEM_4B, A, 102), 1);
+
+    // An AMO in the granule
+    req_ok ("LR.D", funct5_LR, MEM_8B, A, 0);
+    req_ok ("AMOADD.W", funct5_AMOADD, MEM_4B, A + 32, 0);
+    check ("SC.D after AMO in granule", req_ok ("SC.D", funct5_SC, MEM_8B, A, 103), 1);
+
+    // Stores and AMOs just outside the granule do not cancel
+    store (MEM_4B, A, 100);
+    req_ok ("LR.W", funct5_LR, MEM_4B, A, 0);
+    store (MEM_8B, A + 64, 0);
+    store (MEM_8B, A - 8, 0);
+    req_ok ("AMOOR.D", funct5_AMOOR, MEM_8B, A + 128, 1);
+    check ("SC.W after accesses outside granule",
+	   req_ok ("SC.W", funct5_SC, MEM_4B, A, 104), 0);
+    check ("SC.W after accesses outside granule: mem", load (MEM_4B, A), 104);
+
+    // Loads do not cancel
+    req_ok ("LR.W", funct5_LR, MEM_4B, A, 0);
+    load (MEM_4B, A);
+    load (MEM_8B, A + 8);
+    check ("SC.W after loads", req_ok ("SC.W", funct5_SC, MEM_4B, A, 105), 0);
+}
+
+// ****************************************************************
+
+int main (int argc, char *argv [])
+{
+    c_mems_devices_init (ADDR_BASE_MEM, SIZE_B_MEM);
+
+    test_amo_w_sign_extension ();
+    test_amo_min_max ();
+    test_lr_sc ();
+    test_reservation_cancel ();
+
+    fprintf (stdout, "mem_test: %0d checks, %0d failed: %s\n",
+	     n_checks, n_failures, ((n_failures == 0) ? "PASS" : "FAIL"));
+    return ((n_failures == 0) ? 0 : 1);
+}
+
+// ****************************************************************
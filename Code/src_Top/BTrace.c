@@ -0,0 +1,563 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Binary pipeline trace sink (+btrace).  See BTrace.h for the file
+// format.
+
+// ftrace() (Utils.bsv) calls c_btrace_event() for each pipeline event.
+// Events are appended to one of two buffers; when it fills, it is
+// handed to a writer thread (which compresses it, with -D BTRACE_ZSTD,
+// and writes it out) while the simulation fills the other buffer.  The
+// simulation only waits if the writer falls a whole buffer behind.
+
+// The writer thread also appends, for each block, its file offset and
+// range of inums (and any stage definitions in it) to an index file
+// (<trace>.idx), so the index is usable even after a crash.
+
+// Triggered tracing, so that a long run need not be traced throughout.
+// Env variables (read when the trace is opened):
+//     BTRACE_START=inum:<n> | pc:<addr> | cycle:<n> | tohost
+//         Events are written from the first event with inum >= n, or
+//         pc == addr, or cycle >= n, or from the first write to tohost
+//         (see btrace_trigger()).  Default: from the start.
+//     BTRACE_STOP_AFTER=<m>
+//         ... for instructions up to (trigger inum + m - 1).
+//     BTRACE_FLIGHT=<k>
+//         Flight recorder: keep the last k events that were not written
+//         in a ring, and write them out (btrace_flight_dump()) when the
+//         trigger fires, and on memory errors (MEM_RSP_ERR, wild
+//         addresses) and tohost FAIL.  With BTRACE_FLIGHT but no
+//         BTRACE_START, only these dumps are written.
+// Until the trigger fires, an event costs a compare and (with a flight
+// recorder) a copy into the ring.
+
+// ****************************************************************
+// Includes from C lib
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef BTRACE_ZSTD
+#include <zstd.h>
+#endif
+
+// ----------------
+// Local includes
+
+#include "BTrace.h"
+
+// ****************************************************************
+
+// Events per buffer (and per block in the file)
+#define BUF_EVENTS  (64 * 1024)
+
+#ifdef BTRACE_ZSTD
+#define ZSTD_LEVEL  3
+#endif
+
+static FILE *fp     = NULL;
+static FILE *fp_idx = NULL;    // index, written by the writer thread
+
+// ----------------
+// Stage labels.  Labels are string constants in the BSV code, so the
+// same label usually arrives with the same pointer: look up the
+// pointer in a small direct-mapped cache first (and confirm with a
+// compare, since a simulator may pass labels in reused buffers).
+
+static char      stage_labels [BTRACE_MAX_STAGES][BTRACE_MAX_LABEL_LEN + 1];
+static int       n_stages = 0;
+
+#define LABEL_CACHE_SIZE  64
+
+static const char *label_cache_ptr   [LABEL_CACHE_SIZE];
+static uint16_t    label_cache_stage [LABEL_CACHE_SIZE];
+
+// ----------------
+// Double buffer, shared with the writer thread
+
+static BTrace_Event *bufs [2];
+static int           cur_buf  = 0;    // being filled by the simulation
+static uint32_t      n_cur    = 0;
+
+static pthread_t       writer_thread;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cond  = PTHREAD_COND_INITIALIZER;
+static BTrace_Event   *pending_buf = NULL;    // handed to the writer
+static uint32_t        n_pending   = 0;
+static bool            closing     = false;
+
+// Stats
+static uint64_t n_events_total = 0;
+static uint64_t n_bytes_total  = 0;
+
+// ----------------
+// Triggered tracing and flight recorder (see top of file)
+
+typedef enum { TRIGGER_NONE, TRIGGER_INUM, TRIGGER_PC, TRIGGER_CYCLE, TRIGGER_TOHOST } Trigger_Kind;
+
+static Trigger_Kind  trigger_kind = TRIGGER_NONE;
+static const char   *trigger_spec = NULL;          // BTRACE_START
+static uint64_t      trigger_val  = 0;
+static bool          triggered    = true;          // false while waiting for the trigger
+static uint64_t      stop_after   = 0;             // 0: no limit
+static uint64_t      stop_inum    = UINT64_MAX;    // write events of inums below this
+static uint64_t      last_inum    = 0;
+
+static BTrace_Event *flight_ring    = NULL;
+static uint32_t      flight_size    = 0;           // 0: no flight recorder
+static uint32_t      flight_next    = 0;
+static uint32_t      flight_n       = 0;
+static uint64_t      n_flight_dumps = 0;
+
+// ****************************************************************
+// Writer thread: write out each buffer handed over, as one block
+
+static
+void write_index_entry (const BTrace_Index_Entry *p)
+{
+    if (fwrite (p, sizeof (*p), 1, fp_idx) != 1) {
+	fprintf (stdout, "ERROR: %s: write to index file failed\n", __FUNCTION__);
+	exit (1);
+    }
+}
+
+// Append the index entries for a block (at offset) to the index file:
+// one for each stage definition in it, then one for the block
+
+static
+void add_index_entries (const uint64_t offset, const BTrace_Event *events, const uint32_t n_events)
+{
+    BTrace_Index_Entry e;
+    memset (& e, 0, sizeof (e));
+    e.offset      = offset;
+    e.min_inum    = UINT64_MAX;
+    e.max_inum    = 0;
+    e.first_cycle = UINT64_MAX;
+    e.n_events    = n_events;
+    e.kind        = BTRACE_INDEX_BLOCK;
+    for (uint32_t j = 0; j < n_events; j++) {
+	if (events [j].stage == BTRACE_STAGE_DEF) {
+	    BTrace_Index_Entry def;
+	    memset (& def, 0, sizeof (def));
+	    memcpy (& def, & (events [j]), BTRACE_MAX_LABEL_LEN + 1);
+	    def.n_events = events [j].instr;
+	    def.kind     = BTRACE_INDEX_STAGE;
+	    write_index_entry (& def);
+	    continue;
+	}
+	if (e.first_cycle == UINT64_MAX)
+	    e.first_cycle = events [j].cycle;
+	if (events [j].inum < e.min_inum) e.min_inum = events [j].inum;
+	if (events [j].inum > e.max_inum) e.max_inum = events [j].inum;
+    }
+    write_index_entry (& e);
+}
+
+static
+void write_block (const BTrace_Event *events, const uint32_t n_events, void *zbuf)
+{
+    const size_t raw_B = n_events * sizeof (BTrace_Event);
+
+    BTrace_Block_Header hdr;
+    memset (& hdr, 0, sizeof (hdr));
+    hdr.codec    = BTRACE_CODEC_RAW;
+    hdr.n_events = n_events;
+    hdr.stored_B = raw_B;
+    const void *payload = events;
+
+#ifdef BTRACE_ZSTD
+    size_t z_B = ZSTD_compress (zbuf, ZSTD_compressBound (raw_B), events, raw_B, ZSTD_LEVEL);
+    if (ZSTD_isError (z_B)) {
+	fprintf (stdout, "ERROR: %s: ZSTD_compress: %s\n", __FUNCTION__, ZSTD_getErrorName (z_B));
+	exit (1);
+    }
+    if (z_B < raw_B) {
+	hdr.codec    = BTRACE_CODEC_ZSTD;
+	hdr.stored_B = z_B;
+	payload      = zbuf;
+    }
+#endif
+
+    if ((fwrite (& hdr, sizeof (hdr), 1, fp) != 1)
+	|| (fwrite (payload, hdr.stored_B, 1, fp) != 1)) {
+	fprintf (stdout, "ERROR: %s: write to trace file failed\n", __FUNCTION__);
+	exit (1);
+    }
+
+    // The block is in the file before the index points at it
+    fflush (fp);
+    add_index_entries (n_bytes_total, events, n_events);
+    fflush (fp_idx);
+
+    n_bytes_total += sizeof (hdr) + hdr.stored_B;
+}
+
+static
+void *writer_loop (void *arg)
+{
+    void *zbuf = NULL;
+#ifdef BTRACE_ZSTD
+    zbuf = malloc (ZSTD_compressBound (BUF_EVENTS * sizeof (BTrace_Event)));
+    if (zbuf == NULL) {
+	fprintf (stdout, "ERROR: %s: unable to malloc compression buffer\n", __FUNCTION__);
+	exit (1);
+    }
+#endif
+
+    pthread_mutex_lock (& mutex);
+    while (true) {
+	while ((pending_buf == NULL) && (! closing))
+	    pthread_cond_wait (& cond, & mutex);
+	if (pending_buf == NULL)
+	    break;
+	BTrace_Event *buf = pending_buf;
+	uint32_t      n   = n_pending;
+	pthread_mutex_unlock (& mutex);
+
+	write_block (buf, n, zbuf);
+
+	pthread_mutex_lock (& mutex);
+	pending_buf = NULL;
+	pthread_cond_broadcast (& cond);
+    }
+    pthread_mutex_unlock (& mutex);
+    free (zbuf);
+    return NULL;
+}
+
+// ----------------
+// Hand the current buffer to the writer (waiting until the writer has
+// finished with the previous one), and switch to the other buffer
+
+static
+void hand_over_cur_buf (void)
+{
+    if (n_cur == 0)
+	return;
+    pthread_mutex_lock (& mutex);
+    while (pending_buf != NULL)
+	pthread_cond_wait (& cond, & mutex);
+    pending_buf = bufs [cur_buf];
+    n_pending   = n_cur;
+    pthread_cond_broadcast (& cond);
+    pthread_mutex_unlock (& mutex);
+
+    cur_buf = 1 - cur_buf;
+    n_cur   = 0;
+}
+
+static
+void append_event (const BTrace_Event *e)
+{
+    bufs [cur_buf][n_cur] = *e;
+    n_cur++;
+    n_events_total++;
+    if (n_cur == BUF_EVENTS)
+	hand_over_cur_buf ();
+}
+
+// ****************************************************************
+// Stage index for a label, defining a new one if necessary
+
+static
+uint16_t stage_of_label (const char *label)
+{
+    const uint32_t h = (((uintptr_t) label) >> 3) % LABEL_CACHE_SIZE;
+    if ((label_cache_ptr [h] == label)
+	&& (strncmp (stage_labels [label_cache_stage [h]], label, BTRACE_MAX_LABEL_LEN) == 0))
+	return label_cache_stage [h];
+
+    int j;
+    for (j = 0; j < n_stages; j++)
+	if (strncmp (stage_labels [j], label, BTRACE_MAX_LABEL_LEN) == 0)
+	    break;
+
+    if (j == n_stages) {
+	if (n_stages == BTRACE_MAX_STAGES) {
+	    fprintf (stdout, "ERROR: %s: more than %0d distinct stage labels\n",
+		     __FUNCTION__, BTRACE_MAX_STAGES);
+	    exit (1);
+	}
+	strncpy (stage_labels [j], label, BTRACE_MAX_LABEL_LEN);
+	stage_labels [j][BTRACE_MAX_LABEL_LEN] = 0;
+	n_stages++;
+
+	BTrace_Event def;
+	memset (& def, 0, sizeof (def));
+	memcpy (& def, stage_labels [j], strlen (stage_labels [j]));
+	def.instr = j;
+	def.stage = BTRACE_STAGE_DEF;
+	append_event (& def);
+    }
+
+    label_cache_ptr   [h] = label;
+    label_cache_stage [h] = j;
+    return j;
+}
+
+// ****************************************************************
+// Triggered tracing
+
+static
+void start_window (const uint64_t inum, const char *reason)
+{
+    btrace_flight_dump (reason);
+    triggered = true;
+    if (stop_after != 0)
+	stop_inum = inum + stop_after;
+    fprintf (stdout, "INFO: btrace: trigger (%s) at I_%0" PRIu64 "\n", reason, inum);
+}
+
+// Parse env variables BTRACE_START, BTRACE_STOP_AFTER, BTRACE_FLIGHT
+
+static
+void triggers_init_from_env (void)
+{
+    const char *s = getenv ("BTRACE_START");
+    if (s != NULL) {
+	const char *arg = NULL;
+	if      (strncmp (s, "inum:",  5) == 0) { trigger_kind = TRIGGER_INUM;  arg = s + 5; }
+	else if (strncmp (s, "pc:",    3) == 0) { trigger_kind = TRIGGER_PC;    arg = s + 3; }
+	else if (strncmp (s, "cycle:", 6) == 0) { trigger_kind = TRIGGER_CYCLE; arg = s + 6; }
+	else if (strcmp  (s, "tohost")    == 0) { trigger_kind = TRIGGER_TOHOST; }
+	char *end = NULL;
+	if (arg != NULL)
+	    trigger_val = strtoull (arg, & end, 0);
+	if ((trigger_kind == TRIGGER_NONE) || ((arg != NULL) && ((end == arg) || (*end != 0)))) {
+	    fprintf (stdout, "ERROR: BTRACE_START: cannot parse: %s\n", s);
+	    fprintf (stdout, "    Expecting inum:<n>, pc:<addr>, cycle:<n> or tohost\n");
+	    exit (1);
+	}
+	trigger_spec = s;
+	triggered    = false;
+	fprintf (stdout, "INFO: btrace: starts at %s\n", s);
+    }
+
+    s = getenv ("BTRACE_STOP_AFTER");
+    if (s != NULL) {
+	stop_after = strtoull (s, NULL, 0);
+	fprintf (stdout, "INFO: btrace: stops after %0" PRIu64 " instructions\n", stop_after);
+	if (triggered)
+	    stop_inum = stop_after;
+    }
+
+    s = getenv ("BTRACE_FLIGHT");
+    if (s != NULL) {
+	flight_size = strtoul (s, NULL, 0);
+	if (flight_size != 0) {
+	    flight_ring = (BTrace_Event *) malloc (flight_size * sizeof (BTrace_Event));
+	    if (flight_ring == NULL) {
+		fprintf (stdout, "ERROR: BTRACE_FLIGHT: unable to malloc %0d events\n", flight_size);
+		exit (1);
+	    }
+	    if (trigger_kind == TRIGGER_NONE)
+		triggered = false;    // dumps only
+	    fprintf (stdout, "INFO: btrace: flight recorder of %0d events\n", flight_size);
+	}
+    }
+}
+
+// ****************************************************************
+// Flush and close at exit (including $finish)
+
+static
+void btrace_close (void)
+{
+    if (fp == NULL)
+	return;
+
+    hand_over_cur_buf ();
+    pthread_mutex_lock (& mutex);
+    closing = true;
+    pthread_cond_broadcast (& cond);
+    pthread_mutex_unlock (& mutex);
+    pthread_join (writer_thread, NULL);
+
+    fclose (fp);
+    fp = NULL;
+    fclose (fp_idx);
+    fp_idx = NULL;
+    fprintf (stdout, "INFO: btrace: %0" PRIu64 " events, %0" PRIu64 " bytes\n",
+	     n_events_total, n_bytes_total);
+    if (n_flight_dumps != 0)
+	fprintf (stdout, "INFO: btrace: %0" PRIu64 " flight-recorder dumps\n", n_flight_dumps);
+}
+
+// ****************************************************************
+// ****************************************************************
+// ****************************************************************
+// Extern functions called from BSV
+
+// ================================================================
+// import "BDPI"
+// function Action c_btrace_open (String filename);
+
+#ifdef __cplusplus
+// 'C' linkage is necessary for linking with Verilator object files
+extern "C" {
+void c_btrace_open (const char *filename);
+}
+#endif
+
+void c_btrace_open (const char *filename)
+{
+    if (fp != NULL)
+	return;
+
+    fp = fopen (filename, "wb");
+    if (fp == NULL) {
+	fprintf (stdout, "ERROR: %s: unable to open trace file: %s\n", __FUNCTION__, filename);
+	exit (1);
+    }
+    char index_filename [1024];
+    snprintf (index_filename, sizeof (index_filename), "%s.idx", filename);
+    fp_idx = fopen (index_filename, "wb");
+    if (fp_idx == NULL) {
+	fprintf (stdout, "ERROR: %s: unable to open index file: %s\n", __FUNCTION__, index_filename);
+	exit (1);
+    }
+
+    BTrace_File_Header hdr;
+    memset (& hdr, 0, sizeof (hdr));
+    memcpy (hdr.magic, BTRACE_MAGIC, sizeof (hdr.magic));
+    hdr.version      = BTRACE_VERSION;
+    hdr.event_size_B = sizeof (BTrace_Event);
+    if (fwrite (& hdr, sizeof (hdr), 1, fp) != 1) {
+	fprintf (stdout, "ERROR: %s: write to trace file failed\n", __FUNCTION__);
+	exit (1);
+    }
+    n_bytes_total = sizeof (hdr);
+
+    BTrace_Index_Header idx_hdr;
+    memset (& idx_hdr, 0, sizeof (idx_hdr));
+    memcpy (idx_hdr.magic, BTRACE_INDEX_MAGIC, sizeof (idx_hdr.magic));
+    idx_hdr.version      = BTRACE_INDEX_VERSION;
+    idx_hdr.entry_size_B = sizeof (BTrace_Index_Entry);
+    if (fwrite (& idx_hdr, sizeof (idx_hdr), 1, fp_idx) != 1) {
+	fprintf (stdout, "ERROR: %s: write to index file failed\n", __FUNCTION__);
+	exit (1);
+    }
+    fflush (fp_idx);
+
+    for (int j = 0; j < 2; j++) {
+	bufs [j] = (BTrace_Event *) malloc (BUF_EVENTS * sizeof (BTrace_Event));
+	if (bufs [j] == NULL) {
+	    fprintf (stdout, "ERROR: %s: unable to malloc trace buffers\n", __FUNCTION__);
+	    exit (1);
+	}
+    }
+
+    if (pthread_create (& writer_thread, NULL, writer_loop, NULL) != 0) {
+	fprintf (stdout, "ERROR: %s: pthread_create failed\n", __FUNCTION__);
+	exit (1);
+    }
+    atexit (btrace_close);
+
+#ifdef BTRACE_ZSTD
+    fprintf (stdout, "INFO: Binary trace file is: %s (zstd-compressed)\n", filename);
+#else
+    fprintf (stdout, "INFO: Binary trace file is: %s\n", filename);
+#endif
+
+    triggers_init_from_env ();
+}
+
+// ================================================================
+// import "BDPI"
+// function Action c_btrace_event (Bit #(64) cycle,
+//                                 Bit #(64) inum,
+//                                 Bit #(64) pc,
+//                                 Bit #(32) instr,
+//                                 String    label);
+
+#ifdef __cplusplus
+// 'C' linkage is necessary for linking with Verilator object files
+extern "C" {
+void c_btrace_event (const uint64_t  cycle,
+		     const uint64_t  inum,
+		     const uint64_t  pc,
+		     const uint32_t  instr,
+		     const char     *label);
+}
+#endif
+
+void c_btrace_event (const uint64_t  cycle,
+		     const uint64_t  inum,
+		     const uint64_t  pc,
+		     const uint32_t  instr,
+		     const char     *label)
+{
+    if (fp == NULL)
+	return;
+
+    last_inum = inum;
+    if (__builtin_expect (! triggered, 0)) {
+	if (((trigger_kind == TRIGGER_INUM)  && (inum  >= trigger_val))
+	    || ((trigger_kind == TRIGGER_PC)    && (pc    == trigger_val))
+	    || ((trigger_kind == TRIGGER_CYCLE) && (cycle >= trigger_val)))
+	    start_window (inum, trigger_spec);
+    }
+    const bool to_file = (triggered && (inum < stop_inum));
+    if ((! to_file) && (flight_size == 0))
+	return;
+
+    BTrace_Event e;
+    e.stage    = stage_of_label (label);
+    e.cycle    = cycle;
+    e.inum     = inum;
+    e.pc       = pc;
+    e.instr    = instr;
+    e.reserved = 0;
+    if (to_file)
+	append_event (& e);
+    else {
+	flight_ring [flight_next] = e;
+	flight_next = ((flight_next + 1 == flight_size) ? 0 : (flight_next + 1));
+	if (flight_n < flight_size)
+	    flight_n++;
+    }
+}
+
+// ****************************************************************
+// ****************************************************************
+// ****************************************************************
+// Extern functions called from the C models (see BTrace.h)
+
+// ================================================================
+// A write to tohost: fires the 'tohost' trigger
+
+void btrace_trigger (const char *reason)
+{
+    if ((fp == NULL) || triggered || (trigger_kind != TRIGGER_TOHOST))
+	return;
+    start_window (last_inum, reason);
+}
+
+// ================================================================
+// Write out (and empty) the flight recorder, e.g., on a memory error.
+// The events are older than the point of the dump, but are written
+// after any events already in the trace.
+
+void btrace_flight_dump (const char *reason)
+{
+    if ((fp == NULL) || (flight_n == 0))
+	return;
+
+    fprintf (stdout, "INFO: btrace: flight recorder: %0d events before %s (I_%0" PRIu64 ")\n",
+	     flight_n, reason, last_inum);
+    uint32_t j = ((flight_next + flight_size - flight_n) % flight_size);
+    for (uint32_t k = 0; k < flight_n; k++) {
+	append_event (& (flight_ring [j]));
+	j = ((j + 1 == flight_size) ? 0 : (j + 1));
+    }
+    flight_next = 0;
+    flight_n    = 0;
+    n_flight_dumps++;
+}
+
+// ****************************************************************
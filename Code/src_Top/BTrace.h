@@ -0,0 +1,122 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+#pragma once
+
+// ****************************************************************
+// Binary pipeline trace (+btrace): the compact alternative to the
+// "Trace ..." lines of the text log (see ftrace() in Utils.bsv).
+
+// File format (all integers little-endian):
+//     BTrace_File_Header
+//     zero or more blocks, each:
+//         BTrace_Block_Header
+//         payload of stored_B bytes, which is either n_events
+//         BTrace_Events (codec BTRACE_CODEC_RAW), or one zstd frame
+//         that decompresses to them (codec BTRACE_CODEC_ZSTD)
+
+// Events appear in the order in which they were traced (i.e., by
+// cycle, not by inum), except that a flight-recorder dump (see
+// BTrace.c) follows events already written.  Stage labels ("F", "D",
+// "RR.I", "RET.D", ...) are not fixed: each label gets a small stage
+// index the first time it is traced, and a stage-definition event
+// (stage == BTRACE_STAGE_DEF) precedes the first event that uses it.
+
+// ****************************************************************
+
+#define BTRACE_MAGIC      "BTRACE01"
+#define BTRACE_VERSION    1
+
+#define BTRACE_CODEC_RAW   0
+#define BTRACE_CODEC_ZSTD  1
+
+typedef struct {
+    char      magic [8];      // BTRACE_MAGIC (not NUL-terminated)
+    uint32_t  version;        // BTRACE_VERSION
+    uint32_t  event_size_B;   // sizeof (BTrace_Event)
+} BTrace_File_Header;
+
+typedef struct {
+    uint32_t  codec;          // BTRACE_CODEC_RAW/ZSTD
+    uint32_t  n_events;
+    uint32_t  stored_B;       // size of payload in the file
+    uint32_t  reserved;
+} BTrace_Block_Header;
+
+// ----------------
+// One pipeline event (32 bytes)
+
+typedef struct {
+    uint64_t  cycle;
+    uint64_t  inum;
+    uint64_t  pc;
+    uint32_t  instr;
+    uint16_t  stage;          // stage index, or BTRACE_STAGE_DEF
+    uint16_t  reserved;
+} BTrace_Event;
+
+// Stage-definition event: 'instr' is the stage index being defined,
+// and the 24 bytes of cycle, inum and pc hold its NUL-terminated label.
+
+#define BTRACE_STAGE_DEF       0xFFFF
+#define BTRACE_MAX_STAGES      256
+#define BTRACE_MAX_LABEL_LEN   23
+
+// ****************************************************************
+// Index file (<trace file>.idx), so that a window of instructions can
+// be read without scanning the trace:
+//     BTrace_Index_Header
+//     zero or more BTrace_Index_Entrys, in file order
+// The writer appends the entries for each block as it writes the block
+// (and flushes the trace before the index), so the index is valid, up
+// to the last block written, even if the simulation does not exit
+// cleanly; a reader ignores a partial entry at the end.
+// For each block there is a stage-definition entry for each stage
+// definition in the block, then a block entry.
+// The events of one instruction may be spread over adjacent blocks, so
+// a reader wanting inums [i1..i2] reads every block whose
+// [min_inum..max_inum] overlaps it.
+
+#define BTRACE_INDEX_MAGIC    "BTRIDX01"
+#define BTRACE_INDEX_VERSION  2
+
+typedef struct {
+    char      magic [8];      // BTRACE_INDEX_MAGIC (not NUL-terminated)
+    uint32_t  version;        // BTRACE_INDEX_VERSION
+    uint32_t  entry_size_B;   // sizeof (BTrace_Index_Entry)
+} BTrace_Index_Header;
+
+#define BTRACE_INDEX_BLOCK  0
+#define BTRACE_INDEX_STAGE  1
+
+typedef struct {
+    uint64_t  offset;         // of the block's BTrace_Block_Header
+    uint64_t  min_inum;       // over the block's events (excluding
+    uint64_t  max_inum;       //     stage definitions); min > max if none
+    uint64_t  first_cycle;
+    uint32_t  n_events;
+    uint32_t  kind;           // BTRACE_INDEX_BLOCK/STAGE
+} BTrace_Index_Entry;
+
+// Stage-definition entry (kind BTRACE_INDEX_STAGE): 'n_events' is the
+// stage index being defined, and the 32 bytes of offset .. first_cycle
+// hold its NUL-terminated label.
+
+// ****************************************************************
+// Triggered tracing and flight recorder (see BTrace.c), for the C
+// models.  Both are no-ops unless the trace is open (+btrace).
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A write to tohost (fires BTRACE_START=tohost)
+extern void btrace_trigger (const char *reason);
+
+// An error worth seeing the lead-up to (writes out the flight recorder)
+extern void btrace_flight_dump (const char *reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+// ****************************************************************
@@ -0,0 +1,186 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Server on the System interconnect: CLINT (see CLINT_model.h)
+
+// ****************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "CLINT_model.h"
+
+// ****************************************************************
+
+static const int verbosity = 0;
+
+typedef enum {RC_OK, RC_ERR} RC;    // function return-code
+
+// ****************************************************************
+// CLINT register address offsets
+
+const uint64_t  addr_CLINT_msip     = 0x0000;
+const uint64_t  addr_CLINT_mtimecmp = 0x4000;
+const uint64_t  addr_CLINT_mtime    = 0xBFF8;
+
+// ****************************************************************
+
+struct CLINT_struct {
+    uint64_t  addr_base;
+
+    uint32_t  rg_msip;
+    uint64_t  rg_mtimecmp;
+
+    // MTIME at tick t is (t + mtime_offset) (mod 2^64); writes to MTIME
+    // and idle skips change only the offset.
+    uint64_t  mtime_offset;
+
+    uint64_t  mip;          // CLINT_MIP_MSIP, CLINT_MIP_MTIP
+};
+
+// ****************************************************************
+// Recompute interrupt-pending bits at tick_num
+
+static
+void update_mip (CLINT *clint_p, const uint64_t tick_num)
+{
+    uint64_t mip = 0;
+    if ((clint_p->rg_msip & 0x1) != 0)
+	mip |= CLINT_MIP_MSIP;
+    if (CLINT_mtime (clint_p, tick_num) >= clint_p->rg_mtimecmp)
+	mip |= CLINT_MIP_MTIP;
+    clint_p->mip = mip;
+}
+
+// ****************************************************************
+// CLINT creation and initialization
+
+CLINT *mkCLINT (const uint64_t addr_base)
+{
+    CLINT *clint_p = (CLINT *) malloc (sizeof (CLINT));
+    if (clint_p == NULL) {
+	fprintf (stdout, "ERROR: %s(): unable to malloc CLINT struct\n", __FUNCTION__);
+	exit (1);
+    }
+    clint_p->addr_base    = addr_base;
+    clint_p->rg_msip      = 0;
+    clint_p->rg_mtimecmp  = UINT64_MAX;
+    clint_p->mtime_offset = 0;
+    clint_p->mip          = 0;
+    return clint_p;
+}
+
+// ****************************************************************
+
+uint64_t CLINT_mtime (const CLINT *clint_p, const uint64_t tick_num)
+{
+    return tick_num + clint_p->mtime_offset;
+}
+
+uint64_t CLINT_mip (const CLINT *clint_p)
+{
+    return clint_p->mip;
+}
+
+// ****************************************************************
+
+uint64_t CLINT_tick (CLINT *clint_p, const uint64_t tick_num)
+{
+    update_mip (clint_p, tick_num);
+
+    const uint64_t mtime = CLINT_mtime (clint_p, tick_num);
+    if ((clint_p->mip & CLINT_MIP_MTIP) != 0)
+	return UINT64_MAX;
+    return tick_num + (clint_p->rg_mtimecmp - mtime);
+}
+
+// ****************************************************************
+
+uint64_t CLINT_skip_to_mtimecmp (CLINT          *clint_p,
+				 const uint64_t  tick_num,
+				 const uint64_t  max_ticks)
+{
+    const uint64_t mtime = CLINT_mtime (clint_p, tick_num);
+    if ((clint_p->rg_mtimecmp == UINT64_MAX) || (mtime >= clint_p->rg_mtimecmp))
+	return 0;
+
+    uint64_t n_ticks = clint_p->rg_mtimecmp - mtime;
+    if (n_ticks > max_ticks)
+	n_ticks = max_ticks;
+    clint_p->mtime_offset += n_ticks;
+    update_mip (clint_p, tick_num);
+    return n_ticks;
+}
+
+// ****************************************************************
+// The main MMIO function.
+
+int CLINT_try_mem_access (CLINT          *clint_p,
+			  uint8_t        *rdata_p,
+			  const bool      is_read,
+			  const uint64_t  addr,
+			  const uint32_t  size_B,
+			  const uint8_t  *wdata_p,
+			  const uint64_t  tick_num)
+{
+    const uint64_t offset = addr - clint_p->addr_base;
+
+    uint64_t wdata = 0;
+    memcpy (& wdata, wdata_p, 8);
+
+    // 'reg_offset' is 0 or 4, the byte offset within an 8-byte register
+    uint64_t *reg_p      = NULL;
+    uint64_t  reg_offset = offset & 0x7;
+    uint64_t  mtime      = CLINT_mtime (clint_p, tick_num);
+    uint64_t  msip       = clint_p->rg_msip;
+
+    if ((offset == addr_CLINT_msip) && (size_B == 4))
+	reg_p = & msip;
+    else if (((offset & (~ 0x7ull)) == addr_CLINT_mtimecmp)
+	     && ((size_B == 4) || (reg_offset == 0)))
+	reg_p = & (clint_p->rg_mtimecmp);
+    else if (((offset & (~ 0x7ull)) == addr_CLINT_mtime)
+	     && ((size_B == 4) || (reg_offset == 0)))
+	reg_p = & mtime;
+    else {
+	if (verbosity != 0)
+	    fprintf (stdout, "ERROR: CLINT: %s: wild address %08" PRIx64 " size %0d\n",
+		     __FUNCTION__, addr, size_B);
+	return RC_ERR;
+    }
+
+    if (is_read) {
+	uint64_t rdata = ((size_B == 4)
+			  ? ((*reg_p >> (reg_offset * 8)) & 0xFFFFFFFFull)
+			  : *reg_p);
+	memcpy (rdata_p, & rdata, 8);
+    }
+    else {
+	if (size_B == 4) {
+	    const uint64_t mask = (0xFFFFFFFFull << (reg_offset * 8));
+	    *reg_p = ((*reg_p & (~ mask)) | ((wdata << (reg_offset * 8)) & mask));
+	}
+	else
+	    *reg_p = wdata;
+
+	if (reg_p == & msip)
+	    clint_p->rg_msip = (msip & 0x1);
+	else if (reg_p == & mtime)
+	    clint_p->mtime_offset = mtime - tick_num;
+
+	if (verbosity != 0)
+	    fprintf (stdout, "CLINT: tick %0" PRId64 ": msip %0x mtime %0" PRId64
+		     " mtimecmp %0" PRId64 "\n",
+		     tick_num, clint_p->rg_msip, CLINT_mtime (clint_p, tick_num),
+		     clint_p->rg_mtimecmp);
+    }
+
+    update_mip (clint_p, tick_num);
+    return RC_OK;
+}
+
+// ****************************************************************
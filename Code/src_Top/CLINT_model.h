@@ -0,0 +1,78 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+#pragma once
+
+// ****************************************************************
+// Server on the System interconnect: CLINT (core-local interruptor)
+// Registers (offsets from addr_base):
+//     0x0000    MSIP      (4 bytes; bit 0 is the machine software interrupt)
+//     0x4000    MTIMECMP  (8 bytes)
+//     0xBFF8    MTIME     (8 bytes)
+// MTIMECMP and MTIME may be accessed as one 8-byte word or as two
+// 4-byte halves.
+
+// MTIME is not counted tick by tick; it is kept as an offset from the
+// tick number given by the system, so that the CLINT costs nothing on
+// ticks where no timer event is due.
+
+typedef  struct CLINT_struct  CLINT;
+
+#define SIZE_B_CLINT  0x10000
+
+// Bits in the result of CLINT_mip() (as in the RISC-V MIP CSR)
+#define CLINT_MIP_MSIP  (1 << 3)
+#define CLINT_MIP_MTIP  (1 << 7)
+
+// ****************************************************************
+// CLINT creation and initialization; MTIME is 0 at tick 0, and
+// MTIMECMP is all-ones (no timer interrupt).
+
+extern
+CLINT *mkCLINT (const uint64_t addr_base);
+
+// ****************************************************************
+// Value of MTIME at tick_num
+
+extern
+uint64_t CLINT_mtime (const CLINT *clint_p, const uint64_t tick_num);
+
+// ----------------
+// Interrupt-pending bits (CLINT_MIP_MSIP, CLINT_MIP_MTIP), as of the
+// most recent tick() or MMIO access
+
+extern
+uint64_t CLINT_mip (const CLINT *clint_p);
+
+// ****************************************************************
+// 'tick' updates the interrupt-pending bits for tick_num, and returns
+// the tick at which it next needs to be called (when MTIME will reach
+// MTIMECMP), or UINT64_MAX if there is no such tick.
+
+extern
+uint64_t CLINT_tick (CLINT *clint_p, const uint64_t tick_num);
+
+// ****************************************************************
+// Advance MTIME towards MTIMECMP (skipping idle time) by at most
+// max_ticks, if MTIME is below MTIMECMP and MTIMECMP is not all-ones.
+// Returns the number of ticks skipped (0 if none).
+
+extern
+uint64_t CLINT_skip_to_mtimecmp (CLINT          *clint_p,
+				 const uint64_t  tick_num,
+				 const uint64_t  max_ticks);
+
+// ****************************************************************
+// The main MMIO function (size_B is 4 or 8; rdata_p and wdata_p point
+// at 8-byte buffers).
+// Returns 0 if no error; non-zero on error.
+
+extern
+int CLINT_try_mem_access (CLINT          *clint_p,
+			  uint8_t        *rdata_p,
+			  const bool      is_read,
+			  const uint64_t  addr,
+			  const uint32_t  size_B,
+			  const uint8_t  *wdata_p,
+			  const uint64_t  tick_num);
+
+// ****************************************************************
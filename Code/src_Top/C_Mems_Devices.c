@@ -22,11 +22,24 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <signal.h>
+#include <fcntl.h>
 
 // ----------------
 // Local includes
 
 #include "UART_model.h"
+#include "CLINT_model.h"
+#include "Elf_Loader.h"
+#include "Memhex_Loader.h"
+#include "Device_Registry.h"
+#include "BTrace.h"
+#include "PC_Profile.h"
 
 // ****************************************************************
 // Debugging message control
@@ -87,6 +100,7 @@ static int verbosity_MMIO       = 0;
 #define CLIENT_IMEM  0
 #define CLIENT_DMEM  1
 #define CLIENT_MMIO  2
+#define CLIENT_DBG   3
 
 static
 void fprintf_client (FILE *fp, const char *pre, const uint32_t client, const char *post)
@@ -110,8 +124,26 @@ void fprintf_client (FILE *fp, const char *pre, const uint32_t client, const cha
 static uint64_t addr_base_mem = 0;
 static uint64_t size_B_mem    = 0;
 
+// mem_array is a sparse anonymous mapping (see mk_mem_array()): host
+// pages are only committed when the RISC-V program first touches them.
 static uint8_t *mem_array = NULL;
 
+// ----------------
+// CLINT (MTIME, MTIMECMP, MSIP)
+
+#define ADDR_BASE_CLINT 0x02000000
+
+static CLINT *clint_p = NULL;
+
+// Interrupt-request lines (see devices_tick()): bit positions in MIP.
+// The UART drives MEIP directly (there is no PLIC).
+// The CPU's only interrupt input is MTIP (mkMems_Devices.mv_MTIP), so
+// the UART line is visible in the irq word from c_devices_tick() but
+// cannot interrupt the hart; programs poll the UART's LSR.  The
+// CLINT's MSIP register can be read and written, but raises no line.
+#define IRQ_MTIP  7
+#define IRQ_MEIP  11
+
 // ----------------
 // UART
 
@@ -143,8 +175,8 @@ void fprint_mems_devices_info (FILE *fp)
     fprintf (fp, " size_B_mem:  0x%08" PRIx64 " (%0" PRId64 ") bytes\n",
 	     size_B_mem, size_B_mem);
 
-    fprintf (fp, "   ADDR_BASE_UART: 0x%08x", ADDR_BASE_UART);
-    fprintf (fp, " SIZE_B_UART: 0x%08x (%0d) bytes\n", SIZE_B_UART, SIZE_B_UART);
+    fprintf (fp, "  Devices\n");
+    fprint_devices (fp);
 }
 
 // Print byte-array data, with special case as integer if <= 8 bytes
@@ -205,92 +237,1263 @@ void fprint_mem_req (FILE *fp,
     fprintf (fp, "\n");
 }
 
-// ================================================================
-// Load memhex32 file data into memory array
-
-// Parse hex number allowing '_' and ' ' spacers
+// ================================================================
+// Instruction-fetch counters: fetches served by the fast path (aligned
+// and entirely in memory) vs. by the general path (misaligned, not in
+// memory, or with memory verbosity on).
+
+static uint64_t n_fetches_fast    = 0;
+static uint64_t n_fetches_general = 0;
+
+static
+void fprint_fetch_stats (FILE *fp)
+{
+    const uint64_t n_fetches = n_fetches_fast + n_fetches_general;
+    if (n_fetches == 0) return;
+
+    fprintf (fp, "Fetches: %0" PRId64 " fast path, %0" PRId64 " general path (%0.2f%% fast)\n",
+	     n_fetches_fast, n_fetches_general,
+	     (100.0 * n_fetches_fast) / n_fetches);
+}
+
+// ================================================================
+// Sparse backing store for memory
+
+// Reserve (but do not commit) host virtual memory for mem_array.
+// Untouched pages read as zero and cost no host RAM.
+
+static
+uint8_t *mk_mem_array (const uint64_t size_B)
+{
+    void *p = mmap (NULL, size_B,
+		    PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		    -1, 0);
+    if (p == MAP_FAILED)
+	return NULL;
+    return (uint8_t *) p;
+}
+
+// Bits of a /proc/self/pagemap entry (one uint64_t per host page)
+#define PAGEMAP_PRESENT    (1ULL << 63)
+#define PAGEMAP_SWAPPED    (1ULL << 62)
+#define PAGEMAP_FILE       (1ULL << 61)
+#define PAGEMAP_EXCLUSIVE  (1ULL << 56)
+
+// Read the pagemap entries of the n_pages pages of mem_array, without
+// touching mem_array itself.  Returns a malloc'd array, or NULL if
+// pagemap is unavailable.
+
+static
+uint64_t *mem_pagemap (const uint64_t page_size_B, const uint64_t n_pages)
+{
+    int fd = open ("/proc/self/pagemap", O_RDONLY);
+    if (fd < 0)
+	return NULL;
+
+    uint64_t *entries = (uint64_t *) malloc (n_pages * sizeof (uint64_t));
+    const off_t offset = (off_t) ((((uintptr_t) mem_array) / page_size_B) * sizeof (uint64_t));
+    const uint64_t chunk = 65536;
+    uint64_t j = 0;
+    while ((entries != NULL) && (j < n_pages)) {
+	const uint64_t n = minimum (chunk, n_pages - j);
+	const ssize_t  size_B = n * sizeof (uint64_t);
+	if (pread (fd, & (entries [j]), size_B, offset + (j * sizeof (uint64_t))) != size_B) {
+	    free (entries);
+	    entries = NULL;
+	}
+	j += n;
+    }
+    close (fd);
+    return entries;
+}
+
+// Memory statistics at exit (env variable MEM_STATS).
+// Committed pages of mem_array are private pages the simulation wrote
+// (present and exclusively mapped, or swapped out), from
+// /proc/self/pagemap.  Pages that were only read (mapped to the host's
+// shared zero page) and pages mapped from a checkpoint file but not
+// yet written (page cache) are not counted as committed.
+
+static
+int64_t proc_status_KiB (const char *field)
+{
+    FILE *fp = fopen ("/proc/self/status", "r");
+    if (fp == NULL)
+	return -1;
+
+    const size_t n_field = strlen (field);
+    char    line [256];
+    int64_t val = -1;
+    while (fgets (line, sizeof (line), fp) != NULL)
+	if ((strncmp (line, field, n_field) == 0) && (line [n_field] == ':')) {
+	    val = strtoll (& (line [n_field + 1]), NULL, 10);
+	    break;
+	}
+    fclose (fp);
+    return val;
+}
+
+static
+void fprint_mem_stats (FILE *fp)
+{
+    if (mem_array == NULL) return;
+
+    const uint64_t page_size_B = (uint64_t) sysconf (_SC_PAGESIZE);
+    const uint64_t n_pages     = (size_B_mem + page_size_B - 1) / page_size_B;
+    uint64_t      *pagemap     = mem_pagemap (page_size_B, n_pages);
+
+    if (pagemap == NULL)
+	fprintf (fp, "Mem stats: committed pages unknown (no /proc/self/pagemap)\n");
+    else {
+	uint64_t n_committed = 0;
+	uint64_t n_file      = 0;
+	for (uint64_t j = 0; j < n_pages; j++) {
+	    const uint64_t e = pagemap [j];
+	    if ((e & PAGEMAP_SWAPPED) != 0)
+		n_committed++;
+	    else if ((e & PAGEMAP_PRESENT) == 0)
+		continue;
+	    else if ((e & PAGEMAP_FILE) != 0)
+		n_file++;
+	    else if ((e & PAGEMAP_EXCLUSIVE) != 0)
+		n_committed++;
+	}
+	free (pagemap);
+
+	fprintf (fp, "Mem stats: committed pages %0" PRId64 " of %0" PRId64, n_committed, n_pages);
+	fprintf (fp, " (%0" PRId64 " KiB of %0" PRId64 " KiB; page size %0" PRId64 " B)\n",
+		 (n_committed * page_size_B) >> 10, size_B_mem >> 10, page_size_B);
+	if (n_file != 0)
+	    fprintf (fp, "           checkpoint pages mapped, not written %0" PRId64 "\n", n_file);
+    }
+
+    struct rusage ru;
+    getrusage (RUSAGE_SELF, & ru);
+    fprintf (fp, "           simulator RSS %0" PRId64 " KiB (anon %0" PRId64 " KiB),"
+	     " peak RSS %0ld KiB\n",
+	     proc_status_KiB ("VmRSS"), proc_status_KiB ("RssAnon"), ru.ru_maxrss);
+}
+
+static
+void fprint_mem_stats_at_exit (void)
+{
+    fprint_mem_stats (stdout);
+    fprint_fetch_stats (stdout);
+}
+
+// ================================================================
+// Load ELF and memhex32 files into memory.
+// Env variable ELF      is a ':'-separated list of ELF files
+// Env variable MEMHEX32 is a ':'-separated list of memhex32 files
+// If neither is defined, load the default memhex32 file.
+// Env variable MEMHEX32_THREADS > 1 selects the parallel memhex32 loader.
+
+static
+char default_memhex_filename[] = "test.memhex32";
+
+// If an ELF file defines a 'tohost' symbol in memory (rather than in
+// GPIO), stores to it are treated just like stores to GPIO tohost.
+static bool     has_tohost_mem  = false;
+static uint64_t addr_tohost_mem = 0;
+
+static
+double elapsed_secs (const struct timespec *t0_p)
+{
+    struct timespec t1;
+    clock_gettime (CLOCK_MONOTONIC, & t1);
+    return ((t1.tv_sec - t0_p->tv_sec) + ((t1.tv_nsec - t0_p->tv_nsec) * 1e-9));
+}
+
+static
+void load_elfs (char *filenames, int verbosity)
+{
+    for (char *filename = strtok (filenames, ":");
+	 filename != NULL;
+	 filename = strtok (NULL, ":")) {
+
+	fprintf (stdout, "Loading ELF file %s\n", filename);
+
+	struct timespec t0;
+	clock_gettime (CLOCK_MONOTONIC, & t0);
+
+	Elf_Info elf_info;
+	int rc = load_elf (filename, mem_array, addr_base_mem, size_B_mem, & elf_info, verbosity);
+	if (rc != 0) exit (1);
+
+	const double secs = elapsed_secs (& t0);
+	fprintf (stdout, "    %0" PRId64 " bytes in %0.3f ms; entry 0x%08" PRIx64 "\n",
+		 elf_info.n_bytes_loaded, secs * 1e3, elf_info.entry);
+	if (elf_info.has_start && (elf_info.addr_start != elf_info.entry))
+	    fprintf (stdout, "    _start 0x%08" PRIx64 "\n", elf_info.addr_start);
+
+	if (elf_info.has_tohost) {
+	    const uint64_t a = elf_info.addr_tohost;
+	    fprintf (stdout, "    tohost 0x%08" PRIx64 "\n", a);
+	    if ((addr_base_mem <= a) && (a < (addr_base_mem + size_B_mem))) {
+		has_tohost_mem  = true;
+		addr_tohost_mem = a;
+	    }
+	}
+
+	pc_profile_add_symbols (elf_info.syms, elf_info.n_syms);
+	free_elf_info (& elf_info);
+    }
+}
+
+static
+void load_memhex32_timed (const char *filename, int verbosity)
+{
+    const char *s_threads = getenv ("MEMHEX32_THREADS");
+    const int   n_threads = ((s_threads == NULL) ? 1 : atoi (s_threads));
+
+    struct timespec t0;
+    clock_gettime (CLOCK_MONOTONIC, & t0);
+
+    uint64_t n_bytes;
+    int rc = load_memhex32 (filename, mem_array, addr_base_mem, size_B_mem,
+			    n_threads, verbosity, & n_bytes);
+    if (rc != 0) exit (1);
+
+    const double secs = elapsed_secs (& t0);
+    fprintf (stdout, "    %0" PRId64 " bytes in %0.3f ms (%0.1f MB/s, %0d thread%s)\n",
+	     n_bytes, secs * 1e3, ((secs > 0) ? ((n_bytes / secs) * 1e-6) : 0.0),
+	     n_threads, ((n_threads > 1) ? "s" : ""));
+}
+
+static
+void load_memhex32s (char *filenames, int verbosity)
+{
+    for (char *filename = strtok (filenames, ":");
+	 filename != NULL;
+	 filename = strtok (NULL, ":")) {
+
+	fprintf (stdout, "Loading memhex file %s\n", filename);
+	load_memhex32_timed (filename, verbosity);
+    }
+}
+
+static
+void load_images (int verbosity)
+{
+    char *elf_filenames    = getenv ("ELF");
+    char *memhex_filenames = getenv ("MEMHEX32");
+
+    if (elf_filenames != NULL) {
+	fprintf (stdout, "Loading ELF files from environment variable ELF\n");
+	char *s = strdup (elf_filenames);
+	load_elfs (s, verbosity);
+	free (s);
+    }
+
+    if (memhex_filenames != NULL) {
+	fprintf (stdout, "Loading memhex files from environment variable MEMHEX32\n");
+	char *s = strdup (memhex_filenames);
+	load_memhex32s (s, verbosity);
+	free (s);
+    }
+    else if (elf_filenames == NULL) {
+	fprintf (stdout, "Loading memhex file %s\n", default_memhex_filename);
+	fprintf (stdout, "    (default file---no env variables ELF or MEMHEX32)\n");
+	load_memhex32_timed (default_memhex_filename, verbosity);
+    }
+}
+
+// ================================================================
+// Writes to tohost (in GPIO, or in mem if the ELF file says so).
+// A value with LSB set ends the simulation: PASS if the remaining
+// bits (testnum) are 0, else FAIL.
+
+static
+void c_write_tohost (const char *where, const uint32_t tohost_val)
+{
+    btrace_trigger ("tohost");
+    if (((tohost_val & 0x1) == 0) || (rg_tohost == tohost_val))
+	return;
+
+    // Let pending UART output appear before the PASS/FAIL message
+    if (uart_p != NULL)
+	UART_16550_flush (uart_p);
+
+    uint32_t testnum = (tohost_val >> 1);
+    if (testnum == 0) {
+	fprintf (stdout, "\n%s tohost PASS\n", where);
+	exit(0);
+    }
+    else {
+	fprintf (stdout, "\n%s tohost FAIL on testnum %0d\n", where, testnum);
+	btrace_flight_dump ("tohost FAIL");
+	exit(1);
+    }
+    rg_tohost = tohost_val;
+}
+
+// ================================================================
+// Checkpoints: save/restore the contents of memory (only non-zero
+// pages), the UART state, rg_tohost and the location of tohost in memory.
+// Note: CPU state (PC, registers, CSRs) is in BSV and is not saved;
+// after a restore the CPU still starts at its reset PC.
+
+// Env variable CHECKPOINT_SAVE names a file to save to, at exit, or
+//   earlier on SIGUSR1 or when reaching CHECKPOINT_SAVE_INUM (if given).
+// Env variable CHECKPOINT_RESTORE names a file to restore from at init,
+//   instead of loading ELF/memhex32 files.
+// On save, only populated pages are read and checked for non-zero
+// contents: those that /proc/self/pagemap shows as present or swapped
+// out, plus those mapped from the file at restore (which are not
+// present until the program touches them).  Pages never touched are
+// not read at all.  If pagemap is unavailable, every page is checked.
+
+// File format:
+//   Checkpoint_Header
+//   UART state (uart_size_B bytes)
+//   page index: n_pages x uint64_t page numbers (in increasing order)
+//   padding to a page boundary
+//   page data: n_pages x page_size_B bytes (at offset_data)
+// Page data is page-aligned so that it can be mmap'd directly into mem_array.
+
+#define CHECKPOINT_MAGIC "RVMEMCK2"
+
+typedef struct {
+    char      magic [8];
+    uint64_t  addr_base_mem;
+    uint64_t  size_B_mem;
+    uint64_t  page_size_B;
+    uint64_t  n_pages;
+    uint64_t  offset_data;
+    uint32_t  rg_tohost;
+    uint32_t  uart_size_B;
+    uint32_t  has_tohost_mem;
+    uint32_t  reserved;
+    uint64_t  addr_tohost_mem;
+} Checkpoint_Header;
+
+static char *checkpoint_save_filename = NULL;
+
+// Save when a request's inum reaches this (SIGUSR1 sets it to 0)
+static volatile uint64_t checkpoint_save_inum = UINT64_MAX;
+
+static bool checkpoint_saved = false;
+
+// Page numbers (increasing) mapped from the checkpoint file at restore
+static uint64_t *restored_index   = NULL;
+static uint64_t  n_restored_pages = 0;
+
+static
+bool page_is_zero (const uint8_t *p, const uint64_t page_size_B)
+{
+    const uint64_t *p64 = (const uint64_t *) p;
+    for (uint64_t j = 0; j < (page_size_B / 8); j++)
+	if (p64 [j] != 0) return false;
+    return true;
+}
+
+static
+void checkpoint_save (const char *filename)
+{
+    fprintf (stdout, "Saving checkpoint to %s\n", filename);
+
+    struct timespec t0;
+    clock_gettime (CLOCK_MONOTONIC, & t0);
+
+    const uint64_t page_size_B = (uint64_t) sysconf (_SC_PAGESIZE);
+    const uint64_t n_pages_mem = (size_B_mem + page_size_B - 1) / page_size_B;
+
+    // Find pages to save: populated and non-zero
+    uint64_t *index = (uint64_t *) malloc (n_pages_mem * sizeof (uint64_t));
+    if (index == NULL) {
+	fprintf (stdout, "ERROR: %s: unable to malloc page index\n", __FUNCTION__);
+	exit (1);
+    }
+    uint64_t *pagemap  = mem_pagemap (page_size_B, n_pages_mem);
+    uint64_t  n_pages  = 0;
+    uint64_t  jr       = 0;    // next entry in restored_index
+    for (uint64_t j = 0; j < n_pages_mem; j++) {
+	bool populated = ((pagemap == NULL)
+			  || ((pagemap [j] & (PAGEMAP_PRESENT | PAGEMAP_SWAPPED)) != 0));
+	while ((jr < n_restored_pages) && (restored_index [jr] < j))
+	    jr++;
+	if ((jr < n_restored_pages) && (restored_index [jr] == j))
+	    populated = true;
+	if (populated && (! page_is_zero (& (mem_array [j * page_size_B]), page_size_B)))
+	    index [n_pages++] = j;
+    }
+    free (pagemap);
+
+    const size_t uart_size_B = UART_16550_checkpoint_size ();
+    uint8_t      uart_buf [uart_size_B];
+    UART_16550_checkpoint_save (uart_p, uart_buf);
+
+    Checkpoint_Header hdr;
+    memset (& hdr, 0, sizeof (hdr));
+    memcpy (hdr.magic, CHECKPOINT_MAGIC, 8);
+    hdr.addr_base_mem = addr_base_mem;
+    hdr.size_B_mem    = size_B_mem;
+    hdr.page_size_B   = page_size_B;
+    hdr.n_pages       = n_pages;
+    hdr.rg_tohost     = rg_tohost;
+    hdr.uart_size_B   = uart_size_B;
+    hdr.has_tohost_mem  = has_tohost_mem;
+    hdr.addr_tohost_mem = addr_tohost_mem;
+    const uint64_t offset_index = sizeof (hdr) + uart_size_B;
+    hdr.offset_data   = ((offset_index + (n_pages * sizeof (uint64_t)) + page_size_B - 1)
+			 & (~ (page_size_B - 1)));
+
+    FILE *fp = fopen (filename, "w");
+    if (fp == NULL) {
+	fprintf (stdout, "ERROR: %s: unable to open %s\n", __FUNCTION__, filename);
+	exit (1);
+    }
+    bool ok = ((fwrite (& hdr, sizeof (hdr), 1, fp) == 1)
+	       && (fwrite (uart_buf, uart_size_B, 1, fp) == 1)
+	       && (fwrite (index, sizeof (uint64_t), n_pages, fp) == n_pages)
+	       && (fseek (fp, hdr.offset_data, SEEK_SET) == 0));
+    for (uint64_t j = 0; ok && (j < n_pages); j++)
+	ok = (fwrite (& (mem_array [index [j] * page_size_B]), page_size_B, 1, fp) == 1);
+    ok = ((fclose (fp) == 0) && ok);
+    if (! ok) {
+	fprintf (stdout, "ERROR: %s: unable to write %s\n", __FUNCTION__, filename);
+	exit (1);
+    }
+    free (index);
+
+    fprintf (stdout, "    %0" PRId64 " pages (%0" PRId64 " KiB) in %0.3f ms\n",
+	     n_pages, (n_pages * page_size_B) >> 10, elapsed_secs (& t0) * 1e3);
+    checkpoint_saved = true;
+}
+
+static
+void checkpoint_save_at_exit (void)
+{
+    if ((checkpoint_save_filename != NULL) && (! checkpoint_saved))
+	checkpoint_save (checkpoint_save_filename);
+}
+
+static
+void checkpoint_sigusr1_handler (int sig)
+{
+    checkpoint_save_inum = 0;
+}
+
+static
+void checkpoint_init_save (void)
+{
+    checkpoint_save_filename = getenv ("CHECKPOINT_SAVE");
+    if (checkpoint_save_filename == NULL) return;
+
+    fprintf (stdout, "Checkpoint will be saved to %s\n", checkpoint_save_filename);
+
+    char *s_inum = getenv ("CHECKPOINT_SAVE_INUM");
+    if (s_inum != NULL) {
+	checkpoint_save_inum = strtoull (s_inum, NULL, 0);
+	fprintf (stdout, "    at I_%0" PRId64 "\n", checkpoint_save_inum);
+    }
+    else
+	fprintf (stdout, "    at exit, or on SIGUSR1\n");
+
+    signal (SIGUSR1, checkpoint_sigusr1_handler);
+    atexit (checkpoint_save_at_exit);
+}
+
+// Restore; page data is mmap'd (copy-on-write) directly into mem_array,
+// so restoring does not read the pages until the program touches them.
+
+static
+void checkpoint_restore (const char *filename)
+{
+    fprintf (stdout, "Restoring checkpoint from %s\n", filename);
+
+    struct timespec t0;
+    clock_gettime (CLOCK_MONOTONIC, & t0);
+
+    int fd = open (filename, O_RDONLY);
+    if (fd < 0) {
+	fprintf (stdout, "ERROR: %s: unable to open %s\n", __FUNCTION__, filename);
+	exit (1);
+    }
+
+    Checkpoint_Header hdr;
+    const uint64_t page_size_B = (uint64_t) sysconf (_SC_PAGESIZE);
+    if ((pread (fd, & hdr, sizeof (hdr), 0) != sizeof (hdr))
+	|| (memcmp (hdr.magic, CHECKPOINT_MAGIC, 8) != 0)) {
+	fprintf (stdout, "ERROR: %s: %s is not a checkpoint file\n", __FUNCTION__, filename);
+	exit (1);
+    }
+    if ((hdr.addr_base_mem != addr_base_mem)
+	|| (hdr.size_B_mem != size_B_mem)
+	|| (hdr.page_size_B != page_size_B)
+	|| (hdr.uart_size_B != UART_16550_checkpoint_size ())) {
+	fprintf (stdout, "ERROR: %s: checkpoint does not match this simulator\n", __FUNCTION__);
+	fprintf (stdout, "    mem [0x%08" PRIx64 ", size 0x%0" PRIx64 "], page size %0" PRId64
+		 ", UART state %0d bytes\n",
+		 hdr.addr_base_mem, hdr.size_B_mem, hdr.page_size_B, hdr.uart_size_B);
+	exit (1);
+    }
+
+    // Don't trust the file: the index must be strictly increasing page
+    // numbers within memory, and the page data must be in the file
+    // (else a bad file could make mmap (MAP_FIXED) replace host memory
+    // outside mem_array, or fault later).
+    const uint64_t n_pages_mem = (size_B_mem + page_size_B - 1) / page_size_B;
+    struct stat st;
+    if ((hdr.n_pages > n_pages_mem)
+	|| ((hdr.offset_data & (page_size_B - 1)) != 0)
+	|| (fstat (fd, & st) != 0)
+	|| (hdr.offset_data > (uint64_t) st.st_size)
+	|| ((((uint64_t) st.st_size) - hdr.offset_data) / page_size_B < hdr.n_pages)) {
+	fprintf (stdout, "ERROR: %s: %s is corrupt or truncated\n", __FUNCTION__, filename);
+	exit (1);
+    }
+
+    uint8_t   uart_buf [hdr.uart_size_B];
+    uint64_t *index = (uint64_t *) malloc ((hdr.n_pages + 1) * sizeof (uint64_t));
+    const uint64_t offset_index = sizeof (hdr) + hdr.uart_size_B;
+    const ssize_t  index_size_B = hdr.n_pages * sizeof (uint64_t);
+    if ((index == NULL)
+	|| (pread (fd, uart_buf, hdr.uart_size_B, sizeof (hdr)) != hdr.uart_size_B)
+	|| (pread (fd, index, index_size_B, offset_index) != index_size_B)) {
+	fprintf (stdout, "ERROR: %s: %s is truncated\n", __FUNCTION__, filename);
+	exit (1);
+    }
+    for (uint64_t j = 0; j < hdr.n_pages; j++)
+	if ((index [j] >= n_pages_mem) || ((j != 0) && (index [j] <= index [j - 1]))) {
+	    fprintf (stdout, "ERROR: %s: bad page index [%0" PRId64 "]: 0x%0" PRIx64 "\n",
+		     __FUNCTION__, j, index [j]);
+	    exit (1);
+	}
+
+    // Map each run of consecutive pages with one mmap
+    uint64_t j = 0;
+    while (j < hdr.n_pages) {
+	uint64_t k = j + 1;
+	while ((k < hdr.n_pages) && (index [k] == index [k - 1] + 1))
+	    k++;
+	void *p = mmap (& (mem_array [index [j] * page_size_B]),
+			(k - j) * page_size_B,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE,
+			fd,
+			hdr.offset_data + (j * page_size_B));
+	if (p == MAP_FAILED) {
+	    fprintf (stdout, "ERROR: %s: mmap failed\n", __FUNCTION__);
+	    exit (1);
+	}
+	j = k;
+    }
+    restored_index   = index;    // for checkpoint_save
+    n_restored_pages = hdr.n_pages;
+    close (fd);    // mappings remain valid
+
+    UART_16550_checkpoint_restore (uart_p, uart_buf);
+    rg_tohost       = hdr.rg_tohost;
+    has_tohost_mem  = (hdr.has_tohost_mem != 0);
+    addr_tohost_mem = hdr.addr_tohost_mem;
+    if (has_tohost_mem)
+	fprintf (stdout, "    tohost 0x%08" PRIx64 "\n", addr_tohost_mem);
+
+    fprintf (stdout, "    %0" PRId64 " pages (%0" PRId64 " KiB) in %0.3f ms\n",
+	     hdr.n_pages, (hdr.n_pages * page_size_B) >> 10, elapsed_secs (& t0) * 1e3);
+}
+
+// ================================================================
+// Atomic memory operations (LR, SC, AMOxxx)
+// These are performed with host atomics on mem_array, so that they
+// stay atomic if memory is ever shared by several simulation threads
+// (harts).
+// LR records a reservation (address, size and value loaded) for the
+// hart.  SC succeeds iff the hart has a reservation for the same
+// address and size and memory still holds the value loaded by LR
+// (checked and updated with one host compare-and-swap).
+// Any store, SC or AMO to a reserved granule cancels the reservation.
+
+#define N_HARTS                1
+#define RESERVATION_GRANULE_B  64
+
+typedef struct {
+    bool      valid;
+    uint64_t  addr;
+    uint32_t  size_B;
+    uint64_t  val;       // value loaded by LR
+} Reservation;
+
+static Reservation reservations [N_HARTS];
+static int         n_reservations = 0;    // number of valid reservations
+
+// All CPU clients (IMem, DMem, MMIO) currently belong to hart 0
+#define HART_OF_CLIENT(client)  0
+
+// ----------------
+// Cancel all reservations on the granule containing addr
+
+static inline
+void reservations_cancel (const uint64_t addr)
+{
+    if (__builtin_expect (n_reservations == 0, 1))
+	return;
+
+    for (int h = 0; h < N_HARTS; h++) {
+	if (reservations [h].valid
+	    && (((reservations [h].addr ^ addr) & (~ ((uint64_t) RESERVATION_GRANULE_B - 1))) == 0)) {
+	    reservations [h].valid = false;
+	    n_reservations--;
+	}
+    }
+}
+
+// ----------------
+// Read-modify-write; returns the old value.
+
+#define DEFINE_AMO_FN(fn_name, T, T_signed)				\
+static									\
+T fn_name (T *p, const uint32_t req_type, const T wdata)		\
+{									\
+    switch (req_type) {							\
+    case funct5_AMOSWAP: return __atomic_exchange_n  (p, wdata, __ATOMIC_SEQ_CST); \
+    case funct5_AMOADD:  return __atomic_fetch_add   (p, wdata, __ATOMIC_SEQ_CST); \
+    case funct5_AMOXOR:  return __atomic_fetch_xor   (p, wdata, __ATOMIC_SEQ_CST); \
+    case funct5_AMOAND:  return __atomic_fetch_and   (p, wdata, __ATOMIC_SEQ_CST); \
+    case funct5_AMOOR:   return __atomic_fetch_or    (p, wdata, __ATOMIC_SEQ_CST); \
+    }									\
+    /* MIN/MAX: compare-and-swap loop */				\
+    T old = __atomic_load_n (p, __ATOMIC_SEQ_CST);			\
+    T new_val;								\
+    do {								\
+	switch (req_type) {						\
+	case funct5_AMOMIN:  new_val = (((T_signed) wdata < (T_signed) old) ? wdata : old); break; \
+	case funct5_AMOMAX:  new_val = (((T_signed) wdata > (T_signed) old) ? wdata : old); break; \
+	case funct5_AMOMINU: new_val = ((wdata < old) ? wdata : old); break; \
+	default:             new_val = ((wdata > old) ? wdata : old); break; \
+	}								\
+    } while (! __atomic_compare_exchange_n (p, & old, new_val, false,	\
+					    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)); \
+    return old;								\
+}
+
+DEFINE_AMO_FN (amo_32, uint32_t, int32_t)
+DEFINE_AMO_FN (amo_64, uint64_t, int64_t)
+
+// ----------------
+// (already checked that addr range is in-mem and aligned)
+
+static
+void c_access_mem_AMO (uint8_t        *result_p,
+		       const uint64_t  inum,
+		       const uint32_t  req_type,
+		       const uint32_t  size_B,
+		       const uint64_t  addr,
+		       const uint32_t  client,
+		       uint8_t        *wdata_p)
+{
+    if (verbosity_mem != 0)
+	fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
+
+    uint32_t *status_p = (uint32_t *) result_p;
+    uint8_t  *rdata_p  = & (result_p [4]);
+    memset (rdata_p, 0, 8);
+
+    if ((size_B != 4) && (size_B != 8)) {
+	fprintf (stdout, "ERROR: %s: LR/SC/AMO size must be 4 or 8 bytes\n", __FUNCTION__);
+	fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
+	*status_p = MEM_RSP_ERR;
+	btrace_flight_dump ("MEM_RSP_ERR");
+	return;
+    }
+
+    const uint32_t  hart    = HART_OF_CLIENT (client);
+    Reservation    *res_p   = & (reservations [hart]);
+    uint8_t        *mem_ptr = & (mem_array [addr - addr_base_mem]);
+    uint64_t        wdata   = 0;
+    uint64_t        rdata   = 0;
+    memcpy (& wdata, wdata_p, size_B);
+
+    if (req_type == funct5_LR) {
+	if (size_B == 4)
+	    // LR.W results are sign-extended, like AMO*.W results
+	    rdata = (uint64_t) (int64_t) (int32_t) __atomic_load_n ((uint32_t *) mem_ptr,
+								     __ATOMIC_SEQ_CST);
+	else
+	    rdata = __atomic_load_n ((uint64_t *) mem_ptr, __ATOMIC_SEQ_CST);
+
+	if (! res_p->valid)
+	    n_reservations++;
+	res_p->valid  = true;
+	res_p->addr   = addr;
+	res_p->size_B = size_B;
+	res_p->val    = rdata;
+    }
+    else if (req_type == funct5_SC) {
+	bool ok = (res_p->valid && (res_p->addr == addr) && (res_p->size_B == size_B));
+	if (ok) {
+	    if (size_B == 4) {
+		uint32_t expected = res_p->val;
+		ok = __atomic_compare_exchange_n ((uint32_t *) mem_ptr, & expected, (uint32_t) wdata,
+						  false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	    }
+	    else {
+		uint64_t expected = res_p->val;
+		ok = __atomic_compare_exchange_n ((uint64_t *) mem_ptr, & expected, wdata,
+						  false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	    }
+	}
+	// SC always clears this hart's reservation; a successful SC
+	// cancels others' reservations on the granule.
+	if (res_p->valid) {
+	    res_p->valid = false;
+	    n_reservations--;
+	}
+	if (ok)
+	    reservations_cancel (addr);
+	rdata = (ok ? 0 : 1);
+    }
+    else {
+	switch (req_type) {
+	case funct5_AMOSWAP:
+	case funct5_AMOADD:
+	case funct5_AMOXOR:
+	case funct5_AMOAND:
+	case funct5_AMOOR:
+	case funct5_AMOMIN:
+	case funct5_AMOMAX:
+	case funct5_AMOMINU:
+	case funct5_AMOMAXU:
+	    break;
+	default:
+	    fprintf (stdout, "ERROR: %s: unknown request type", __FUNCTION__);
+	    fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
+	    *status_p = MEM_RSP_ERR;
+	    btrace_flight_dump ("MEM_RSP_ERR");
+	    return;
+	}
+	reservations_cancel (addr);
+	if (size_B == 4)
+	    // AMO*.W results are sign-extended
+	    rdata = (uint64_t) (int64_t) (int32_t) amo_32 ((uint32_t *) mem_ptr, req_type, wdata);
+	else
+	    rdata = amo_64 ((uint64_t *) mem_ptr, req_type, wdata);
+    }
+
+    memcpy (rdata_p, & rdata, 8);
+    *status_p = MEM_RSP_OK;
+
+    if (verbosity_mem != 0)
+	fprint_data (stdout, "    => rdata ", 8, rdata_p, "\n");
+}
+
+// ================================================================
+// Watchpoints ("hardware" triggers on memory accesses)
+// A small table of address ranges, each for any of FETCH, LOAD and
+// STORE accesses (AMOs count as LOAD and STORE; LR as LOAD; SC as
+// STORE).  Requests are checked against the table only if their page
+// is marked in a bitmap (pages below 4 GiB; one flag for all pages
+// above), so that with no watchpoints armed the cost is one test of
+// wp_n_armed per request.
+// On a hit, if the remote-debugger stub is attached, the hit is held
+// for it (c_mems_devices_watchpoint_take_hit()), and the stub halts
+// the CPU, reporting dcsr.cause TRIGGER; the halt takes effect a few
+// instructions after the access.  Without a debugger, the hit is
+// reported and the simulation ends.
+// Note: speculative (wrong-path) fetches and loads can also hit.
+// Env variable WATCHPOINTS is a ','-separated list of
+//     <kinds>:<addr>[+<len>]    kinds: any of 'x' (FETCH), 'r' (LOAD), 'w' (STORE)
+// to arm at init, e.g., WATCHPOINTS=w:0x80001000+8,rw:0x60100000
+
+// WARNING: THESE CODES SHOULD BE IDENTICAL TO DBG_WATCH_* IN vendor/EDB/Dbg_Pkts.h
+#define WP_FETCH  0x1
+#define WP_LOAD   0x2
+#define WP_STORE  0x4
+#define WP_ALL    0x7
+
+#define WP_MAX         16
+#define WP_PAGE_BITS   12
+#define WP_N_PAGES     (1 << (32 - WP_PAGE_BITS))
+
+typedef struct {
+    uint32_t  kinds;    // WP_FETCH/LOAD/STORE
+    uint64_t  addr;
+    uint64_t  len;
+} Watchpoint;
+
+static Watchpoint wp_table [WP_MAX];
+static uint32_t   wp_n_armed = 0;
+static uint64_t   wp_page_bitmap [WP_N_PAGES / 64];
+static bool       wp_high_pages = false;    // some watchpoint is at/above 4 GiB
+
+static bool       wp_dbg_attached = false;
+static bool       wp_hit_valid    = false;
+static uint64_t   wp_hit_addr;      // Address of the access
+static uint32_t   wp_hit_kinds;     // Kinds of the access that matched
+static uint64_t   wp_hit_wp_addr;   // Start address of the watchpoint
+
+static
+void wp_rebuild_bitmap (void)
+{
+    memset (wp_page_bitmap, 0, sizeof (wp_page_bitmap));
+    wp_high_pages = false;
+    for (uint32_t j = 0; j < wp_n_armed; j++) {
+	const uint64_t a_lo = wp_table [j].addr;
+	const uint64_t a_hi = wp_table [j].addr + wp_table [j].len - 1;
+	if ((a_hi >> 32) != 0)
+	    wp_high_pages = true;
+	if ((a_lo >> 32) != 0)
+	    continue;
+	const uint64_t pg_hi = (minimum (a_hi, 0xFFFFFFFFull)) >> WP_PAGE_BITS;
+	for (uint64_t pg = a_lo >> WP_PAGE_BITS; pg <= pg_hi; pg++)
+	    wp_page_bitmap [pg >> 6] |= (1ull << (pg & 0x3F));
+    }
+}
+
+static inline
+bool wp_page_armed (const uint64_t addr)
+{
+    if ((addr >> 32) != 0)
+	return wp_high_pages;
+    const uint64_t pg = addr >> WP_PAGE_BITS;
+    return (((wp_page_bitmap [pg >> 6] >> (pg & 0x3F)) & 1) != 0);
+}
+
+// ----------------
+// Slow path, for requests in a marked page
+
+static
+__attribute__ ((noinline, cold))
+void wp_check (const uint64_t  inum,
+	       const uint32_t  req_type,
+	       const uint32_t  req_size_code,
+	       const uint64_t  addr,
+	       const uint8_t  *wdata_p)
+{
+    uint32_t kinds;
+    switch (req_type) {
+    case funct5_FETCH:   kinds = WP_FETCH; break;
+    case funct5_LOAD:
+    case funct5_LR:      kinds = WP_LOAD;  break;
+    case funct5_STORE:
+    case funct5_SC:      kinds = WP_STORE; break;
+    case funct5_FENCE:
+    case funct5_FENCE_I: return;
+    default:             kinds = WP_LOAD | WP_STORE; break;
+    }
+    const uint64_t size_B = (1 << (req_size_code & 0x3));
+
+    for (uint32_t j = 0; j < wp_n_armed; j++) {
+	const Watchpoint *wp_p = & (wp_table [j]);
+	if (((wp_p->kinds & kinds) == 0)
+	    || ((addr + size_B) <= wp_p->addr)
+	    || (addr >= (wp_p->addr + wp_p->len)))
+	    continue;
+
+	if (! wp_dbg_attached) {
+	    if (uart_p != NULL)
+		UART_16550_flush (uart_p);
+	    fprintf (stdout, "\nWatchpoint %0d (0x%0" PRIx64 " + 0x%0" PRIx64 ") hit:\n",
+		     j, wp_p->addr, wp_p->len);
+	    fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
+	    exit (1);
+	}
+	if (! wp_hit_valid) {
+	    // Keep the first hit until the stub takes it
+	    wp_hit_valid   = true;
+	    wp_hit_addr    = addr;
+	    wp_hit_kinds   = (wp_p->kinds & kinds);
+	    wp_hit_wp_addr = wp_p->addr;
+	}
+	return;
+    }
+}
+
+// ----------------
+// Arm (or disarm) a watchpoint; returns 0 if ok, non-zero if the table
+// is full (arm) or there is no such watchpoint (disarm).
+
+static
+int wp_set (const bool arm, const uint32_t kinds, const uint64_t addr, const uint64_t len)
+{
+    if (arm) {
+	if ((wp_n_armed == WP_MAX) || (len == 0) || ((kinds & WP_ALL) == 0))
+	    return 1;
+	wp_table [wp_n_armed].kinds = (kinds & WP_ALL);
+	wp_table [wp_n_armed].addr  = addr;
+	wp_table [wp_n_armed].len   = len;
+	wp_n_armed++;
+    }
+    else {
+	uint32_t j;
+	for (j = 0; j < wp_n_armed; j++)
+	    if ((wp_table [j].kinds == (kinds & WP_ALL))
+		&& (wp_table [j].addr == addr)
+		&& (wp_table [j].len  == len))
+		break;
+	if (j == wp_n_armed)
+	    return 1;
+	wp_table [j] = wp_table [wp_n_armed - 1];
+	wp_n_armed--;
+    }
+    wp_rebuild_bitmap ();
+    return 0;
+}
+
+// ----------------
+// Arm watchpoints from env variable WATCHPOINTS
+
+static
+void wp_init_from_env (void)
+{
+    const char *spec = getenv ("WATCHPOINTS");
+    if (spec == NULL)
+	return;
+
+    const char *p = spec;
+    while (*p != 0) {
+	uint32_t kinds = 0;
+	for (; (*p != 0) && (*p != ':'); p++) {
+	    if      (*p == 'x') kinds |= WP_FETCH;
+	    else if (*p == 'r') kinds |= WP_LOAD;
+	    else if (*p == 'w') kinds |= WP_STORE;
+	    else break;
+	}
+	char *end;
+	uint64_t addr = 0, len = 1;
+	if (*p == ':') {
+	    addr = strtoull (p + 1, & end, 0);
+	    p = end;
+	    if (*p == '+') {
+		len = strtoull (p + 1, & end, 0);
+		p = end;
+	    }
+	}
+	if (((*p != 0) && (*p != ',')) || (wp_set (true, kinds, addr, len) != 0)) {
+	    fprintf (stdout, "ERROR: WATCHPOINTS: cannot parse, or too many, at: %s\n", p);
+	    fprintf (stdout, "    Expecting <kinds>:<addr>[+<len>],... (kinds: x, r, w)\n");
+	    exit (1);
+	}
+	fprintf (stdout, "Watchpoint: %s%s%s 0x%0" PRIx64 " + 0x%0" PRIx64 "\n",
+		 ((kinds & WP_FETCH) ? "x" : ""),
+		 ((kinds & WP_LOAD)  ? "r" : ""),
+		 ((kinds & WP_STORE) ? "w" : ""),
+		 addr, len);
+	if (*p == ',')
+	    p++;
+    }
+}
+
+// ================================================================
+// Memory-traffic profile
+// Env variable MEM_PROFILE names a file to which counts of all memory
+// requests are written at exit, and also on SIGUSR2 (at the next
+// request); CSV if its name ends in ".csv", else JSON.  Counts are:
+//   requests and bytes per client and request type, and per client and size
+//   outcomes (OK, MISALIGNED, ERR, DEFERRED) per client
+//   requests and bytes per region (memory, each device, none)
+//   FETCH/LOAD/STORE requests per 4 KiB page of memory (hot pages)
+// When MEM_PROFILE is not set, the cost is one predictable branch per request.
+// (The guest PC sampling profiler, PC_PROFILE, is in PC_Profile.c.)
+
+#define PROF_N_CLIENTS   4    // CLIENT_IMEM, CLIENT_DMEM, CLIENT_MMIO, other
+#define PROF_N_TYPES    32    // funct5
+#define PROF_N_STATUS    4    // MEM_RSP_OK .. MEM_REQ_DEFERRED
+#define PROF_PAGE_BITS  12
+
+typedef struct {
+    uint64_t  n_reqs;
+    uint64_t  n_bytes;
+} Prof_Count;
+
+// Regions: prof_regions [0] is memory, [1] is 'none' (wild), the rest are devices
+#define PROF_MAX_REGIONS  34
+
+typedef struct {
+    const Device *dev_p;
+    Prof_Count    count;
+} Prof_Region;
+
+static const char       *prof_filename     = NULL;
+static volatile bool     prof_dump_pending = false;
+
+static Prof_Count   prof_types  [PROF_N_CLIENTS][PROF_N_TYPES];
+static Prof_Count   prof_sizes  [PROF_N_CLIENTS][4];
+static uint64_t     prof_status [PROF_N_CLIENTS][PROF_N_STATUS];
+static Prof_Region  prof_regions [PROF_MAX_REGIONS];
+static int          n_prof_regions = 2;
+
+// Per page of memory: FETCH, LOAD (incl. LR), STORE (incl. SC, AMOs)
+static uint64_t   (*prof_pages) [3] = NULL;
+static uint64_t     n_prof_pages    = 0;
+
+static const char *prof_client_names [PROF_N_CLIENTS] = { "IMEM", "DMEM", "MMIO", "other" };
+static const char *prof_size_names   [4]              = { "1B", "2B", "4B", "8B" };
+static const char *prof_status_names [PROF_N_STATUS]  = { "OK", "MISALIGNED", "ERR", "DEFERRED" };
+
+static
+const char *req_type_name (const uint32_t req_type)
+{
+    switch (req_type) {
+    case funct5_FENCE:   return "FENCE";
+    case funct5_FENCE_I: return "FENCE.I";
+    case funct5_FETCH:   return "FETCH";
+    case funct5_LOAD:    return "LOAD";
+    case funct5_STORE:   return "STORE";
+    case funct5_LR:      return "LR";
+    case funct5_SC:      return "SC";
+    case funct5_AMOSWAP: return "AMOSWAP";
+    case funct5_AMOADD:  return "AMOADD";
+    case funct5_AMOXOR:  return "AMOXOR";
+    case funct5_AMOAND:  return "AMOAND";
+    case funct5_AMOOR:   return "AMOOR";
+    case funct5_AMOMIN:  return "AMOMIN";
+    case funct5_AMOMAX:  return "AMOMAX";
+    case funct5_AMOMINU: return "AMOMINU";
+    case funct5_AMOMAXU: return "AMOMAXU";
+    default:             return NULL;
+    }
+}
+
+static
+Prof_Count *prof_region_count (const uint64_t addr, const uint32_t size_B)
+{
+    if ((addr_base_mem <= addr) && ((addr + size_B) <= (addr_base_mem + size_B_mem)))
+	return & (prof_regions [0].count);
+
+    const Device *dev_p = device_lookup (addr, size_B);
+    if (dev_p == NULL)
+	return & (prof_regions [1].count);
+
+    int j;
+    for (j = 2; j < n_prof_regions; j++)
+	if (prof_regions [j].dev_p == dev_p)
+	    return & (prof_regions [j].count);
+    if (j == PROF_MAX_REGIONS)
+	return & (prof_regions [1].count);
+    prof_regions [j].dev_p = dev_p;
+    n_prof_regions++;
+    return & (prof_regions [j].count);
+}
+
+static
+const char *prof_region_name (const int j)
+{
+    return ((j == 0) ? "mem" : ((j == 1) ? "none" : prof_regions [j].dev_p->name));
+}
+
+// ----------------
+// Write the profile.  Both formats come from the same rows:
+//     <category>, <name>, <requests>, <bytes>
+// (per-page rows are <page addr>, <fetches>, <loads>, <stores>)
+
+static
+void prof_write_row (FILE *fp, const bool csv, bool *first_p,
+		     const char *category, const char *name, const Prof_Count *c)
+{
+    if ((c->n_reqs == 0) && (c->n_bytes == 0))
+	return;
+    if (csv)
+	fprintf (fp, "%s,%s,%0" PRIu64 ",%0" PRIu64 "\n", category, name, c->n_reqs, c->n_bytes);
+    else {
+	fprintf (fp, "%s\n    {\"category\": \"%s\", \"name\": \"%s\", \"reqs\": %0" PRIu64
+		 ", \"bytes\": %0" PRIu64 "}",
+		 ((*first_p) ? "" : ","), category, name, c->n_reqs, c->n_bytes);
+	*first_p = false;
+    }
+}
+
 static
-uint32_t parse_hex (const char *linebuf)
+void mem_profile_write (void)
 {
-    int      j = 0;
-    uint32_t x = 0;
-    while (true) {
-	uint8_t ch = linebuf [j];
-	if      (('A' <= ch) && (ch <= 'F')) x = (x << 4) + (ch - 'A' + 10);
-	else if (('a' <= ch) && (ch <= 'f')) x = (x << 4) + (ch - 'a' + 10);
-	else if (('0' <= ch) && (ch <= '9')) x = (x << 4) + (ch - '0');
-	else if ((ch == ' ') || (ch == '_')) { } // skip
-	else                                 break;  // Done; ignore rest of line
-	j++;
+    const size_t n   = strlen (prof_filename);
+    const bool   csv = ((n >= 4) && (strcmp (prof_filename + n - 4, ".csv") == 0));
+
+    FILE *fp = fopen (prof_filename, "w");
+    if (fp == NULL) {
+	fprintf (stdout, "WARNING: %s: unable to open %s\n", __FUNCTION__, prof_filename);
+	return;
+    }
+
+    bool first = true;
+    char name [64];
+    if (csv)
+	fprintf (fp, "category,name,reqs,bytes\n");
+    else
+	fprintf (fp, "{\n  \"page_size\": %0d,\n  \"counts\": [", (1 << PROF_PAGE_BITS));
+
+    for (int c = 0; c < PROF_N_CLIENTS; c++) {
+	Prof_Count total = {0, 0};
+	for (int t = 0; t < PROF_N_TYPES; t++) {
+	    total.n_reqs  += prof_types [c][t].n_reqs;
+	    total.n_bytes += prof_types [c][t].n_bytes;
+	}
+	prof_write_row (fp, csv, & first, "client", prof_client_names [c], & total);
+    }
+    for (int c = 0; c < PROF_N_CLIENTS; c++)
+	for (int t = 0; t < PROF_N_TYPES; t++) {
+	    const char *s = req_type_name (t);
+	    if (s != NULL)
+		snprintf (name, sizeof (name), "%s.%s", prof_client_names [c], s);
+	    else
+		snprintf (name, sizeof (name), "%s.0x%02x", prof_client_names [c], t);
+	    prof_write_row (fp, csv, & first, "client_req_type", name, & (prof_types [c][t]));
+	}
+    for (int c = 0; c < PROF_N_CLIENTS; c++)
+	for (int z = 0; z < 4; z++) {
+	    snprintf (name, sizeof (name), "%s.%s", prof_client_names [c], prof_size_names [z]);
+	    prof_write_row (fp, csv, & first, "client_size", name, & (prof_sizes [c][z]));
+	}
+    for (int c = 0; c < PROF_N_CLIENTS; c++)
+	for (int s = 0; s < PROF_N_STATUS; s++) {
+	    const Prof_Count count = { prof_status [c][s], 0 };
+	    snprintf (name, sizeof (name), "%s.%s", prof_client_names [c], prof_status_names [s]);
+	    prof_write_row (fp, csv, & first, "client_status", name, & count);
+	}
+    for (int j = 0; j < n_prof_regions; j++)
+	prof_write_row (fp, csv, & first, "region", prof_region_name (j), & (prof_regions [j].count));
+
+    // Hot pages
+    if (csv)
+	fprintf (fp, "\npage,fetches,loads,stores\n");
+    else
+	fprintf (fp, "\n  ],\n  \"pages\": [");
+    first = true;
+    for (uint64_t p = 0; p < n_prof_pages; p++) {
+	const uint64_t *q = prof_pages [p];
+	if ((q [0] | q [1] | q [2]) == 0)
+	    continue;
+	const uint64_t page_addr = addr_base_mem + (p << PROF_PAGE_BITS);
+	if (csv)
+	    fprintf (fp, "0x%08" PRIx64 ",%0" PRIu64 ",%0" PRIu64 ",%0" PRIu64 "\n",
+		     page_addr, q [0], q [1], q [2]);
+	else {
+	    fprintf (fp, "%s\n    {\"page\": \"0x%08" PRIx64 "\", \"fetches\": %0" PRIu64
+		     ", \"loads\": %0" PRIu64 ", \"stores\": %0" PRIu64 "}",
+		     (first ? "" : ","), page_addr, q [0], q [1], q [2]);
+	    first = false;
+	}
     }
-    return x;
+    if (! csv)
+	fprintf (fp, "\n  ]\n}\n");
+
+    if (fclose (fp) != 0)
+	fprintf (stdout, "WARNING: %s: unable to write %s\n", __FUNCTION__, prof_filename);
+    else
+	fprintf (stdout, "INFO: Memory-traffic profile written to %s\n", prof_filename);
 }
 
 static
-char default_memhex_filename[] = "test.memhex32";
+void mem_profile_write_at_exit (void)
+{
+    mem_profile_write ();
+}
+
+static
+void mem_profile_sigusr2_handler (int sig)
+{
+    prof_dump_pending = true;
+}
+
+// ----------------
+// Count one request, after it has been served (result_p holds the status)
 
 static
-void load_memhex32 (int verbosity)
+void mem_profile_count (const uint8_t  *result_p,
+			const uint32_t  req_type,
+			const uint32_t  req_size_code,
+			const uint64_t  addr,
+			const uint32_t  client)
 {
-    char *memhex_filename = getenv ("MEMHEX32");
-    if (memhex_filename != NULL) {
-	fprintf (stdout, "Loading memhex file %s\n", memhex_filename);
-	fprintf (stdout, "    (from environment variable MEMHEX32)\n");
+    const uint32_t c      = ((client < PROF_N_CLIENTS) ? client : (PROF_N_CLIENTS - 1));
+    const uint32_t t      = (req_type % PROF_N_TYPES);
+    const bool     sized  = ((req_type != funct5_FENCE) && (req_type != funct5_FENCE_I)
+			     && (req_size_code <= MEM_8B));
+    const uint32_t size_B = (sized ? (1 << req_size_code) : 0);
+    uint32_t status;
+    memcpy (& status, result_p, 4);
+
+    prof_types [c][t].n_reqs++;
+    prof_types [c][t].n_bytes += size_B;
+    if (sized) {
+	prof_sizes [c][req_size_code].n_reqs++;
+	prof_sizes [c][req_size_code].n_bytes += size_B;
     }
-    else {
-	memhex_filename = default_memhex_filename;
-	fprintf (stdout, "Loading memhex file %s\n", memhex_filename);
-	fprintf (stdout, "    (default file---no env variable MEMHEX32)\n");
+    if (status < PROF_N_STATUS)
+	prof_status [c][status]++;
+
+    if (sized) {
+	Prof_Count *rc = prof_region_count (addr, size_B);
+	rc->n_reqs++;
+	rc->n_bytes += size_B;
+
+	const uint64_t p = ((addr - addr_base_mem) >> PROF_PAGE_BITS);
+	if ((addr >= addr_base_mem) && (p < n_prof_pages)) {
+	    const int k = ((req_type == funct5_FETCH) ? 0
+			   : (((req_type == funct5_LOAD) || (req_type == funct5_LR)) ? 1 : 2));
+	    prof_pages [p][k]++;
+	}
     }
 
-    FILE *fp = fopen (memhex_filename, "r");
-    if (fp == NULL) {
-	fprintf (stdout, "Unable to open memhex file; ignoring; mem is not initialized\n");
+    if (__builtin_expect (prof_dump_pending, 0)) {
+	prof_dump_pending = false;
+	mem_profile_write ();
+    }
+}
+
+static
+void mem_profile_init (void)
+{
+    prof_filename = getenv ("MEM_PROFILE");
+    if (prof_filename == NULL)
 	return;
+
+    n_prof_pages = ((size_B_mem + (1 << PROF_PAGE_BITS) - 1) >> PROF_PAGE_BITS);
+    prof_pages   = (uint64_t (*) [3]) calloc (n_prof_pages, sizeof (prof_pages [0]));
+    if (prof_pages == NULL) {
+	fprintf (stdout, "ERROR: %s: unable to calloc page counts\n", __FUNCTION__);
+	exit (1);
     }
 
-#define LINEBUF_SIZE 256
-    char linebuf [LINEBUF_SIZE];
-    
-    int      line_num = 0;
-    uint64_t addr = 0;
+    fprintf (stdout, "Memory-traffic profile will be written to %s\n", prof_filename);
+    fprintf (stdout, "    at exit, or on SIGUSR2\n");
+    signal (SIGUSR2, mem_profile_sigusr2_handler);
+    atexit (mem_profile_write_at_exit);
+}
+
+// ================================================================
+// Access memory: fast path
+// For aligned FETCH/LOAD/STORE entirely within memory, with no debug
+// printing.  Always inlined with a constant size_B, so that the
+// memcpy()s become single loads/stores.
+
+static inline __attribute__ ((always_inline))
+void c_access_mem_fast (uint8_t        *result_p,
+			const uint32_t  req_type,
+			const uint32_t  size_B,
+			const uint64_t  addr,
+			const uint8_t  *wdata_p)
+{
+    uint8_t *mem_ptr = & (mem_array [addr - addr_base_mem]);
 
-    while (true) {
-	char *p = fgets (linebuf, LINEBUF_SIZE, fp);
-	if (p == NULL) break;
+    if (req_type == funct5_STORE) {
+	memcpy (mem_ptr, wdata_p, size_B);
+	reservations_cancel (addr);
 
-	line_num++;
-    
-	if (linebuf [0] == '@') {
-	    addr = (parse_hex (& (linebuf [1])) << 2);
-	    if (verbosity > 0)
-		fprintf (stdout, "  Setting addr = 0x%08" PRIx64 "\n", addr);
-	}
-	else if (isxdigit (linebuf [0])) {
-	    uint32_t x = parse_hex (linebuf);
-	    if ((addr - addr_base_mem) > (size_B_mem - 4)) {
-		fprintf (stdout,
-			 "ERROR: load_memhex32(): addr 0x%08" PRIx64 " out of bounds\n", addr);
-		fprintf (stdout,
-			 "       Mem size is 0x%08" PRIx64 "\n", size_B_mem);
-		exit (1);
-	    }
-	    memcpy (& (mem_array [addr - addr_base_mem]), & x, 4);
-	    if (verbosity > 1)
-		fprintf (stdout, "Loading mem [%08" PRIx64 "] <= %08x\n", addr, x);
-	    addr += 4;
-	}
-	else {
-	    // Ignore this line
+	if (__builtin_expect (has_tohost_mem && (addr == addr_tohost_mem), 0)) {
+	    uint32_t tohost_val;
+	    memcpy (& tohost_val, mem_ptr, 4);
+	    c_write_tohost ("mem", tohost_val);
 	}
     }
+    else {
+	uint64_t rdata = 0;
+	memcpy (& rdata, mem_ptr, size_B);
+	memcpy (& (result_p [4]), & rdata, 8);
+    }
+
+    uint32_t status = MEM_RSP_OK;
+    memcpy (result_p, & status, 4);
 }
 
 // ================================================================
-// Access memory
+// Access memory: general path (debug printing, unusual requests)
 // (already checked that addr range is in-mem)
 
 static
+__attribute__ ((noinline, cold))
 void c_access_mem (uint8_t        *result_p,
 		   const uint64_t  inum,
 		   const uint32_t  req_type,
@@ -322,6 +1525,13 @@ void c_access_mem (uint8_t        *result_p,
     else if (req_type == funct5_STORE) {
 	// mem [] <= wdata
 	memcpy (mem_ptr, wdata_p, size_B);
+	reservations_cancel (addr);
+
+	if (has_tohost_mem && (addr == addr_tohost_mem)) {
+	    uint32_t tohost_val;
+	    memcpy (& tohost_val, mem_ptr, 4);
+	    c_write_tohost ("mem", tohost_val);
+	}
 
 	if (verbosity != 0)
 	    fprint_data (stdout, "    wdata_p <= ", size_B, wdata_p, "\n");
@@ -330,43 +1540,163 @@ void c_access_mem (uint8_t        *result_p,
 	fprintf (stdout, "ERROR: %s: unknown request type", __FUNCTION__);
 	fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
 	*status_p = MEM_RSP_ERR;
+	btrace_flight_dump ("MEM_RSP_ERR");
     }
 }
 
 // ================================================================
-// Access UART
+// Device access functions (see Device_Registry.h)
+// Requests have already been checked to be LOAD/STORE, in-range and
+// aligned, and read-data has been zeroed.
+
+// ----------------
+// Memory (for completeness; c_mems_devices_req_rsp() accesses memory
+// directly, without the registry lookup)
+
+static
+void dev_access_mem (void           *dev_state,
+		     uint8_t        *result_p,
+		     const uint64_t  inum,
+		     const uint32_t  req_type,
+		     const uint32_t  size_B,
+		     const uint64_t  addr,
+		     uint8_t        *wdata_p)
+{
+    c_access_mem (result_p, inum, req_type, size_B, addr, wdata_p, verbosity_mem);
+}
+
+// ----------------
+// UART
+
+static
+void dev_access_UART (void           *dev_state,
+		      uint8_t        *result_p,
+		      const uint64_t  inum,
+		      const uint32_t  req_type,
+		      const uint32_t  size_B,
+		      const uint64_t  addr,
+		      uint8_t        *wdata_p)
+{
+    UART_16550 *uart_p = (UART_16550 *) dev_state;
+    uint32_t   *status_p = (uint32_t *) result_p;
+    uint8_t    *rdata_p  = & (result_p [4]);
+
+    UART_16550_tick (uart_p, devices_cur_tick ());
+    int rc = UART_16550_try_mem_access (uart_p,
+					rdata_p,
+					(req_type == funct5_LOAD),
+					addr,
+					size_B,
+					*wdata_p);
+    *status_p = ((rc == 0) ? MEM_RSP_OK : MEM_RSP_ERR);
+
+    // The interrupt level follows IER writes, RBR/IIR reads etc. at once
+    device_set_irq (IRQ_MEIP, UART_16550_irq_level (uart_p));
+}
+
+static
+uint64_t dev_tick_UART (void *dev_state, const uint64_t tick_num)
+{
+    UART_16550 *uart_p = (UART_16550 *) dev_state;
+    const uint64_t next_tick = UART_16550_tick (uart_p, tick_num);
+    device_set_irq (IRQ_MEIP, UART_16550_irq_level (uart_p));
+    return next_tick;
+}
+
+// ----------------
+// CLINT
+
+static
+void set_irqs_from_CLINT (const CLINT *clint_p)
+{
+    const uint64_t mip = CLINT_mip (clint_p);
+    device_set_irq (IRQ_MTIP, ((mip & CLINT_MIP_MTIP) != 0));
+}
 
 static
-void c_access_UART (uint8_t        *result_p,
-		    const uint64_t  inum,
-		    const uint32_t  req_type,
-		    const uint32_t  size_B,
-		    const uint64_t  addr,
-		    uint8_t        *wdata_p)
+void dev_access_CLINT (void           *dev_state,
+		       uint8_t        *result_p,
+		       const uint64_t  inum,
+		       const uint32_t  req_type,
+		       const uint32_t  size_B,
+		       const uint64_t  addr,
+		       uint8_t        *wdata_p)
 {
+    CLINT    *clint_p  = (CLINT *) dev_state;
     uint32_t *status_p = (uint32_t *) result_p;
-    if (req_type == funct5_LOAD) {
-	fprintf (stdout, "ERROR: c_mem_access_UART(): LOAD not yet implemented\n");
-	fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
-	*status_p = MEM_RSP_ERR;
-    }
-    else if (req_type == funct5_STORE) {
-	uint8_t ch = *wdata_p;
+    uint8_t  *rdata_p  = & (result_p [4]);
+
+    int rc = CLINT_try_mem_access (clint_p,
+				   rdata_p,
+				   (req_type == funct5_LOAD),
+				   addr,
+				   size_B,
+				   wdata_p,
+				   devices_cur_tick ());
+    *status_p = ((rc == 0) ? MEM_RSP_OK : MEM_RSP_ERR);
+
+    // MTIP follows MTIMECMP/MTIME writes without waiting for a tick
+    set_irqs_from_CLINT (clint_p);
+}
 
-	if (ch == '\r')      { fprintf (stdout, "\r"); fflush (stdout); }
-	else if (ch == '\n') { fprintf (stdout, "\n"); fflush (stdout); }
-	else if (ch <  0x20) fprintf (stdout, "UART: <0x%0x>\n", ch);
-	else if (ch >= 0x7F) fprintf (stdout, "UART: <0x%0x>\n", ch);
-	else                 fprintf (stdout, "%c", ch);
-	*status_p = MEM_RSP_OK;
-    }
-    else {
-	fprintf (stdout, "ERROR: %s: unknown request type", __FUNCTION__);
-	fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
-	*status_p = MEM_RSP_ERR;
-    }
+static
+uint64_t dev_tick_CLINT (void *dev_state, const uint64_t tick_num)
+{
+    CLINT *clint_p = (CLINT *) dev_state;
+    const uint64_t next_tick = CLINT_tick (clint_p, tick_num);
+    set_irqs_from_CLINT (clint_p);
+    return next_tick;
+}
+
+// ----------------
+// GPIO
+
+static
+void dev_access_GPIO (void           *dev_state,
+		      uint8_t        *result_p,
+		      const uint64_t  inum,
+		      const uint32_t  req_type,
+		      const uint32_t  size_B,
+		      const uint64_t  addr,
+		      uint8_t        *wdata_p)
+{
+    uint32_t *status_p = (uint32_t *) result_p;
+
+    uint32_t *p = (uint32_t *) wdata_p;
+    uint32_t tohost_val = *p;
+
+    if ((addr == (ADDR_BASE_GPIO + ADDR_OFFSET_GPIO_TOHOST))
+	&& (req_type == funct5_STORE))
+	c_write_tohost ("GPIO", tohost_val);
+
+    *status_p = MEM_RSP_OK;
+}
+
+// ----------------
+// Register all devices in the system address map
+
+static
+void register_devices (void)
+{
+    int rc = 0;
+    rc |= device_register ("CLINT", ADDR_BASE_CLINT, SIZE_B_CLINT,
+			   clint_p, dev_access_CLINT, dev_tick_CLINT);
+    rc |= device_register ("Mem", addr_base_mem, size_B_mem,
+			   NULL, dev_access_mem, NULL);
+    rc |= device_register ("UART", ADDR_BASE_UART, SIZE_B_UART,
+			   uart_p, dev_access_UART, dev_tick_UART);
+    rc |= device_register ("GPIO", ADDR_BASE_GPIO, SIZE_B_GPIO,
+			   NULL, dev_access_GPIO, NULL);
+    if (rc != 0)
+	exit (1);
 }
 
+// ****************************************************************
+// PC profiling (see PC_Profile.c): set in c_mems_devices_init(), and
+// checked for each instruction fetch in c_mems_devices_req_rsp()
+
+static bool pc_profiling = false;
+
 // ****************************************************************
 // ****************************************************************
 // ****************************************************************
@@ -392,22 +1722,41 @@ void c_mems_devices_init (uint64_t addr_base, uint64_t size_B)
     addr_base_mem = addr_base;
     size_B_mem    = size_B;
 
-    fprintf (stdout, "INFO: %s\n", __FUNCTION__);
-    fprint_mems_devices_info (stdout);
-
-    mem_array = (uint8_t *) malloc (size_B_mem);
+    mem_array = mk_mem_array (size_B_mem);
     if (mem_array == NULL) {
-	fprintf (stdout, "ERROR: unable to malloc C array for memory\n");
+	fprintf (stdout, "ERROR: unable to mmap C array for memory\n");
 	exit (1);
     }
+    if (getenv ("MEM_STATS") != NULL)
+	atexit (fprint_mem_stats_at_exit);
 
-    // TODO: load multiple ELFs/memhex32s
-    const int verbosity = 0;
-    load_memhex32 (verbosity);
+    // Instantiate CLINT and UART models
+    clint_p = mkCLINT (ADDR_BASE_CLINT);
 
-    // Instantiate UART model
     const uint8_t addr_stride = 4;
     uart_p = mkUART_16550 (ADDR_BASE_UART, addr_stride);
+
+    register_devices ();
+
+    fprintf (stdout, "INFO: %s\n", __FUNCTION__);
+    fprint_mems_devices_info (stdout);
+
+    // Before loading ELF files, which supply its symbols
+    pc_profiling = pc_profile_init ();
+
+    char *checkpoint_restore_filename = getenv ("CHECKPOINT_RESTORE");
+    if (checkpoint_restore_filename != NULL)
+	checkpoint_restore (checkpoint_restore_filename);
+    else {
+	const int verbosity = 0;
+	load_images (verbosity);
+    }
+
+    checkpoint_init_save ();
+
+    wp_init_from_env ();
+
+    mem_profile_init ();
 }
 
 // ================================================================
@@ -439,14 +1788,53 @@ void c_mems_devices_req_rsp (uint8_t        *result_p,
 //     followed by at least 64b (8 bytes) of data to CPU (for FETCH, LOAD, LR, SC, AMOxxx)
 // client is 0 for IMem, 1 for DMem, 2 for MMIO
 
-void c_mems_devices_req_rsp (uint8_t        *result_p,
-			     const uint64_t  inum,
-			     const uint32_t  req_type,
-			     const uint32_t  req_size_code,
-			     const uint64_t  addr,
-			     const uint32_t  client,
-			     uint8_t        *wdata_p)
+static inline __attribute__ ((always_inline))
+void mems_devices_req_rsp (uint8_t        *result_p,
+			   const uint64_t  inum,
+			   const uint32_t  req_type,
+			   const uint32_t  req_size_code,
+			   const uint64_t  addr,
+			   const uint32_t  client,
+			   uint8_t        *wdata_p)
 {
+    if (__builtin_expect (inum >= checkpoint_save_inum, 0)) {
+	checkpoint_save_inum = UINT64_MAX;
+	checkpoint_save (checkpoint_save_filename);
+    }
+
+    if (__builtin_expect (wp_n_armed != 0, 0) && wp_page_armed (addr))
+	wp_check (inum, req_type, req_size_code, addr, wdata_p);
+
+    // ----------------
+    // Fast path: aligned FETCH/LOAD/STORE entirely within memory.
+    // (offset wraps around, and fails the range check, if addr < addr_base_mem)
+
+    if ((verbosity_mem == 0)
+	&& ((req_type == funct5_FETCH)
+	    || (req_type == funct5_LOAD)
+	    || (req_type == funct5_STORE))
+	&& (req_size_code <= MEM_8B)) {
+
+	const uint64_t size_B = (1 << req_size_code);
+	const uint64_t offset = addr - addr_base_mem;
+	if (((addr & (size_B - 1)) == 0) && (offset <= (size_B_mem - size_B))) {
+	    switch (req_size_code) {
+	    case MEM_1B: c_access_mem_fast (result_p, req_type, 1, addr, wdata_p); break;
+	    case MEM_2B: c_access_mem_fast (result_p, req_type, 2, addr, wdata_p); break;
+	    case MEM_4B: c_access_mem_fast (result_p, req_type, 4, addr, wdata_p); break;
+	    case MEM_8B: c_access_mem_fast (result_p, req_type, 8, addr, wdata_p); break;
+	    }
+	    n_fetches_fast += (req_type == funct5_FETCH);
+	    return;
+	}
+    }
+
+    // ----------------
+    // General path
+
+    if (req_type == funct5_FETCH)
+	n_fetches_general++;
+
     // Convert size code to size in bytes
     uint8_t size_B = 0;
     switch (req_size_code) {
@@ -461,13 +1849,6 @@ void c_mems_devices_req_rsp (uint8_t        *result_p,
 	exit (1);
     }
 
-    const bool in_mem  = ((addr_base_mem <= addr)
-			  && ((addr + size_B) <= (addr_base_mem + size_B_mem)));
-    const bool in_UART = ((ADDR_BASE_UART <= addr)
-			  && ((addr + size_B) <= (ADDR_BASE_UART + SIZE_B_UART)));
-    const bool in_GPIO = ((ADDR_BASE_GPIO <= addr)
-			  && ((addr + size_B) <= (ADDR_BASE_GPIO + SIZE_B_GPIO)));
-
     if ((req_type == funct5_FENCE) || (req_type == funct5_FENCE_I)) {
 	// These should only come from CLIENT_MMIO
 	// For speculative accesses, FENCE/FENCE.I are handled in mkStore_Buffer (deferred)
@@ -495,7 +1876,23 @@ void c_mems_devices_req_rsp (uint8_t        *result_p,
 	return;
     }
 
-    if ((! in_mem) && (! in_UART) && (! in_GPIO)) {
+    // Memory is by far the most frequent target; check it first
+    const bool in_mem  = ((addr_base_mem <= addr)
+			  && ((addr + size_B) <= (addr_base_mem + size_B_mem)));
+    if (in_mem) {
+	if ((req_type == funct5_FETCH)
+	    || (req_type == funct5_LOAD)
+	    || (req_type == funct5_STORE))
+	    c_access_mem (result_p, inum, req_type, size_B, addr, wdata_p, verbosity_mem);
+	else
+	    c_access_mem_AMO (result_p, inum, req_type, size_B, addr, client, wdata_p);
+	return;
+    }
+
+    // Triage to devices based on address
+    const Device *dev_p = device_lookup (addr, size_B);
+
+    if (dev_p == NULL) {
 	// If speculative (CLIENT_DMEM) defer; else error
 	uint32_t *status_p = (uint32_t *) result_p;
 	if (client == CLIENT_DMEM)
@@ -507,100 +1904,245 @@ void c_mems_devices_req_rsp (uint8_t        *result_p,
 		fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
 	    }
 	    *status_p = MEM_RSP_ERR;
+	    btrace_flight_dump ("wild address");
 	}
 	return;
     }
 
-    // Triage to mem/device units based on address
-    if (in_mem) {
-	c_access_mem (result_p, inum, req_type, size_B, addr, wdata_p, verbosity_mem);
+    if (verbosity_MMIO != 0) {
+	fprintf (stdout, "    In %s\n", dev_p->name);
+	fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
+    }
+
+    // Zero out read-data buffer
+    uint32_t *status_p = (uint32_t *) result_p;
+    uint8_t  *rdata_p  = & (result_p [4]);
+    memset (rdata_p, 0, 8);
+
+    if ((req_type != funct5_LOAD) && (req_type != funct5_STORE)) {
+	// Only allow LOAD/STORE ops
+	fprintf (stdout, "%s: %s req_type is not LOAD/STORE: %0x\n",
+		 __FUNCTION__, dev_p->name, req_type);
+	*status_p = MEM_RSP_ERR;
+	btrace_flight_dump ("MEM_RSP_ERR");
 	return;
     }
 
-    if (in_UART) {
-	if (verbosity_MMIO != 0) {
-	    fprintf (stdout, "    In UART\n");
-	    fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
-	}
+    dev_p->access_fn (dev_p->dev_state, result_p, inum, req_type, size_B, addr, wdata_p);
+    if (*status_p == MEM_RSP_ERR)
+	btrace_flight_dump ("MEM_RSP_ERR");
 
-	// Zero out read-data buffer
-	uint32_t *status_p = (uint32_t *) result_p;
-	uint8_t  *rdata_p  = & (result_p [4]);
-	memset (rdata_p, 0, 8);
+    // The access may have changed the device's next event
+    device_wakeup (dev_p);
+}
 
-	if ((req_type != funct5_LOAD) && (req_type != funct5_STORE)) {
-	    // Only allow LOAD/STORE ops
-	    fprintf (stdout, "%s: UART req_type is not LOAD/STORE: %0x\n",
-		     __FUNCTION__, req_type);
-	    *status_p = MEM_RSP_ERR;
-	}
-	else {
-	    if (verbosity_MMIO != 0) {
-		fprintf (stdout, "    Perform UART MMIO\n");
-	    }
-	    uint8_t y;
-	    int rc = UART_16550_try_mem_access (uart_p,
-						rdata_p,
-						(req_type == funct5_LOAD),
-						addr,
-						size_B,
-						*wdata_p);
-	    *status_p = ((rc == 0) ? MEM_RSP_OK : MEM_RSP_ERR);
-	}
-	return;
+void c_mems_devices_req_rsp (uint8_t        *result_p,
+			     const uint64_t  inum,
+			     const uint32_t  req_type,
+			     const uint32_t  req_size_code,
+			     const uint64_t  addr,
+			     const uint32_t  client,
+			     uint8_t        *wdata_p)
+{
+    mems_devices_req_rsp (result_p, inum, req_type, req_size_code, addr, client, wdata_p);
+
+    if (__builtin_expect (prof_filename != NULL, 0))
+	mem_profile_count (result_p, req_type, req_size_code, addr, client);
+
+    if (__builtin_expect (pc_profiling, 0)
+	&& (req_type == funct5_FETCH)
+	&& (client == CLIENT_IMEM)) {
+	uint32_t status, instr;
+	memcpy (& status, result_p, 4);
+	memcpy (& instr, & (result_p [4]), 4);
+	if (status == MEM_RSP_OK)
+	    pc_profile_fetch (addr, instr, devices_cur_tick ());
     }
+}
 
-    if (in_GPIO) {
-	if (verbosity_MMIO != 0) {
-	    fprintf (stdout, "    In GPIO\n");
-	    fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
-	}
+// ================================================================
+// import "BDPI"
+// function ActionValue #(Bit #(192)) c_devices_tick (Bit #(64) tick_num);
 
-	// Zero out read-data buffer
-	uint32_t *status_p = (uint32_t *) result_p;
-	uint8_t  *rdata_p  = & (result_p [4]);
-	memset (rdata_p, 0, 8);
+#ifdef __cplusplus
+// 'C' linkage is necessary for linking with Verilator object files
+extern "C" {
+void c_devices_tick (uint8_t *result_p, const uint64_t tick_num);
+}
+#endif
 
-	if ((req_type != funct5_LOAD) && (req_type != funct5_STORE)) {
-	    // Only allow LOAD/STORE ops
-	    fprintf (stdout, "%s: GPIO req_type is not LOAD/STORE: %0x\n",
-		     __FUNCTION__, req_type);
-	    *status_p = MEM_RSP_ERR;
-	}
-	else {
-	    if (verbosity_MMIO != 0) {
-		fprintf (stdout, "    Perform GPIO\n");
-	    }
-	    uint32_t *p = (uint32_t *) wdata_p;
-	    uint32_t tohost_val = *p;
-	    
-	    if ((addr == (ADDR_BASE_GPIO + ADDR_OFFSET_GPIO_TOHOST))
-		&& (req_type == funct5_STORE)
-		&& (tohost_val & 0x1)) {
-
-		if (rg_tohost != tohost_val) {
-		    uint32_t testnum = (tohost_val >> 1);
-		    if (testnum == 0) {
-			fprintf (stdout, "\nGPIO tohost PASS\n");
-			exit(0);
-		    }
-		    else {
-			fprintf (stdout, "\nGPIO tohost FAIL on testnum %0d\n", testnum);
-			exit(1);
-		    }
-		    rg_tohost = tohost_val;
-		}
-	    }
+// ----------------
+// Called from BSV with a free-running tick count; lets devices run
+// "concurrently" with the system.
+// BSV calls this only when the devices are due (at the tick returned
+// by the previous call), after an access to a device, and before an
+// access to a device (so that the device sees the current tick); it
+// keeps MTIME itself, as the tick plus the offset returned here.
+// result is { next due tick (64b), interrupt-request lines (64b),
+//             MTIME - tick_num (64b) }.
+
+void c_devices_tick (uint8_t *result_p, const uint64_t tick_num)
+{
+    const uint64_t irqs         = devices_tick (tick_num);
+    const uint64_t mtime_offset = CLINT_mtime (clint_p, tick_num) - tick_num;
 
-	    *status_p = MEM_RSP_OK;
-	}
-	return;
+    // PC profiling samples by tick, at fetches; it needs every tick
+    const uint64_t next_tick = (pc_profiling ? (tick_num + 1) : devices_next_tick ());
+
+    memcpy (& (result_p [0]),  & mtime_offset, 8);
+    memcpy (& (result_p [8]),  & irqs,         8);
+    memcpy (& (result_p [16]), & next_tick,    8);
+}
+
+// ================================================================
+// import "BDPI"
+// function ActionValue #(Bit #(64)) c_mems_devices_idle_skip (Bit #(64) tick_num,
+//                                                              Bit #(64) max_ticks);
+
+#ifdef __cplusplus
+// 'C' linkage is necessary for linking with Verilator object files
+extern "C" {
+uint64_t c_mems_devices_idle_skip (const uint64_t tick_num, const uint64_t max_ticks);
+}
+#endif
+
+// ----------------
+// Called from BSV (with -D IDLE_SKIP) when the hart appears idle,
+// waiting for the timer; advances MTIME towards MTIMECMP at once, by
+// at most max_ticks (which bounds how far a poll for a deadline before
+// MTIMECMP can overshoot it).
+// Refuses if a device has an event pending that the hart should see
+// first.  Returns the number of ticks skipped (0 if none); BSV then
+// calls c_devices_tick() for the new MTIME offset and interrupts.
+
+static uint64_t n_idle_skips         = 0;
+static uint64_t n_idle_ticks_skipped = 0;
+
+static
+void fprint_idle_skip_stats_at_exit (void)
+{
+    fprintf (stdout, "Idle skip: %0" PRId64 " skips, %0" PRId64 " ticks skipped\n",
+	     n_idle_skips, n_idle_ticks_skipped);
+}
+
+uint64_t c_mems_devices_idle_skip (const uint64_t tick_num, const uint64_t max_ticks)
+{
+    if ((uart_p != NULL) && UART_16550_rx_pending (uart_p))
+	return 0;
+
+    const uint64_t n_ticks = CLINT_skip_to_mtimecmp (clint_p, tick_num, max_ticks);
+    if (n_ticks == 0)
+	return 0;
+    set_irqs_from_CLINT (clint_p);
+
+    if (n_idle_skips == 0)
+	atexit (fprint_idle_skip_stats_at_exit);
+    n_idle_skips++;
+    n_idle_ticks_skipped += n_ticks;
+    return n_ticks;
+}
+
+// ****************************************************************
+// ****************************************************************
+// ****************************************************************
+// Extern functions called from C
+
+// ================================================================
+// Block read/write from the remote-debugger stub
+// (vendor/EDB/BDPI_RSPS_TCP_server.c), for Dbg_to_CPU_RW_BLOCK packets:
+// copies directly between buf and mem_array, bypassing the CPU.
+// Returns 0 if ok, non-zero if [addr, addr + n_bytes) is not all memory.
+
+#ifdef __cplusplus
+// 'C' linkage is necessary for linking with Verilator object files
+extern "C" {
+int c_mems_devices_dbg_block_rw (const bool      is_read,
+				 const uint64_t  addr,
+				 const uint32_t  n_bytes,
+				 uint8_t        *buf);
+}
+#endif
+
+int c_mems_devices_dbg_block_rw (const bool      is_read,
+				 const uint64_t  addr,
+				 const uint32_t  n_bytes,
+				 uint8_t        *buf)
+{
+    if ((addr < addr_base_mem)
+	|| (n_bytes > size_B_mem)
+	|| ((addr - addr_base_mem) > (size_B_mem - n_bytes))) {
+	if (verbosity_wild != 0)
+	    fprintf (stdout, "ERROR: %s: [0x%0" PRIx64 ", +%0d) is not in memory\n",
+		     __FUNCTION__, addr, n_bytes);
+	return 1;
+    }
+
+    uint8_t *p = & (mem_array [addr - addr_base_mem]);
+    if (is_read)
+	memcpy (buf, p, n_bytes);
+    else {
+	memcpy (p, buf, n_bytes);
+	for (uint64_t a = addr; a < addr + n_bytes; a += RESERVATION_GRANULE_B)
+	    reservations_cancel (a);
+	if (n_bytes != 0)
+	    reservations_cancel (addr + n_bytes - 1);
     }
+    return 0;
+}
+
+// ================================================================
+// Watchpoints, for the remote-debugger stub (see "Watchpoints" above)
+
+#ifdef __cplusplus
+// 'C' linkage is necessary for linking with Verilator object files
+extern "C" {
+void c_mems_devices_watchpoints_dbg_attach (void);
+int  c_mems_devices_watchpoint_set (const bool      arm,
+				    const uint32_t  kinds,
+				    const uint64_t  addr,
+				    const uint64_t  len);
+bool c_mems_devices_watchpoint_take_hit (uint64_t *p_addr,
+					 uint32_t *p_kinds,
+					 uint64_t *p_wp_addr);
+}
+#endif
+
+// ----------------
+// From now on, hits are held for the stub instead of ending the simulation
+
+void c_mems_devices_watchpoints_dbg_attach (void)
+{
+    wp_dbg_attached = true;
+}
 
-    fprintf (stdout, "ERROR: %s: wild address, but previously checked ok\n",
-	     __FUNCTION__);
-    fprint_mem_req (stdout, inum, req_type, size_B, addr, wdata_p);
-    exit (1);
+// ----------------
+// Returns 0 if ok, non-zero if the table is full (arm) or there is no
+// such watchpoint (disarm)
+
+int c_mems_devices_watchpoint_set (const bool      arm,
+				   const uint32_t  kinds,
+				   const uint64_t  addr,
+				   const uint64_t  len)
+{
+    return wp_set (arm, kinds, addr, len);
+}
+
+// ----------------
+// If there has been a hit since the last call, returns true, with the
+// first such hit in *p_addr (accessed address), *p_kinds (matching
+// kinds of access) and *p_wp_addr (watchpoint start); else false.
+
+bool c_mems_devices_watchpoint_take_hit (uint64_t *p_addr,
+					 uint32_t *p_kinds,
+					 uint64_t *p_wp_addr)
+{
+    if (! wp_hit_valid)
+	return false;
+    *p_addr      = wp_hit_addr;
+    *p_kinds     = wp_hit_kinds;
+    *p_wp_addr   = wp_hit_wp_addr;
+    wp_hit_valid = false;
+    return true;
 }
 
 // ****************************************************************
@@ -0,0 +1,258 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Registry of memory-mapped devices (see Device_Registry.h)
+
+// The registry is a small array of regions kept sorted by address,
+// searched by binary search; the cost of a lookup grows only with
+// the log of the number of devices.  A one-entry cache of the most
+// recently found device short-cuts the search for the common case of
+// repeated accesses to the same device.
+// Tick callbacks are scheduled with a binary min-heap on each device's
+// next tick; devices_tick() looks only at the top of the heap, so the
+// cost of a tick at which no device is due does not grow with the
+// number of devices.
+
+// ****************************************************************
+// Includes from C lib
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+// ----------------
+// Local includes
+
+#include "Device_Registry.h"
+
+// ****************************************************************
+
+#define MAX_DEVICES  32
+
+static Device devices [MAX_DEVICES];    // sorted by addr_base
+static int    n_devices = 0;
+
+static Device *last_device_p = NULL;    // most recent lookup hit
+
+// ----------------
+// Tick scheduler
+
+typedef struct {
+    void           *dev_state;
+    Device_Tick_Fn  tick_fn;
+    uint64_t        next_tick;
+    int             heap_pos;      // position in heap []
+} Ticker;
+
+static Ticker tickers [MAX_DEVICES];
+static int    n_tickers = 0;
+
+// heap [0] is the ticker with the smallest next_tick
+static int    heap [MAX_DEVICES];
+
+static uint64_t cur_tick = 0;
+
+static uint64_t irqs = 0;
+
+// ****************************************************************
+// Heap maintenance
+
+static
+void heap_swap (const int pos_a, const int pos_b)
+{
+    const int a = heap [pos_a];
+    const int b = heap [pos_b];
+    heap [pos_a] = b;    tickers [b].heap_pos = pos_a;
+    heap [pos_b] = a;    tickers [a].heap_pos = pos_b;
+}
+
+static
+void heap_sift_up (int pos)
+{
+    while (pos > 0) {
+	const int parent = (pos - 1) / 2;
+	if (tickers [heap [parent]].next_tick <= tickers [heap [pos]].next_tick)
+	    break;
+	heap_swap (pos, parent);
+	pos = parent;
+    }
+}
+
+static
+void heap_sift_down (int pos)
+{
+    while (true) {
+	const int l = (2 * pos) + 1;
+	const int r = l + 1;
+	int min = pos;
+	if ((l < n_tickers) && (tickers [heap [l]].next_tick < tickers [heap [min]].next_tick))
+	    min = l;
+	if ((r < n_tickers) && (tickers [heap [r]].next_tick < tickers [heap [min]].next_tick))
+	    min = r;
+	if (min == pos)
+	    break;
+	heap_swap (pos, min);
+	pos = min;
+    }
+}
+
+// ****************************************************************
+
+int device_register (const char             *name,
+		     const uint64_t          addr_base,
+		     const uint64_t          size_B,
+		     void                   *dev_state,
+		     const Device_Access_Fn  access_fn,
+		     const Device_Tick_Fn    tick_fn)
+{
+    const uint64_t addr_lim = addr_base + size_B;
+
+    if ((size_B == 0) || (addr_lim < addr_base) || (access_fn == NULL)) {
+	fprintf (stdout, "ERROR: %s: device %s: bad region or access function\n",
+		 __FUNCTION__, name);
+	return 1;
+    }
+    if (n_devices == MAX_DEVICES) {
+	fprintf (stdout, "ERROR: %s: device %s: too many devices (max %0d)\n",
+		 __FUNCTION__, name, MAX_DEVICES);
+	return 1;
+    }
+
+    // Find insertion point, and check for overlap with neighbors
+    int j = 0;
+    while ((j < n_devices) && (devices [j].addr_base < addr_base))
+	j++;
+    if (((j > 0) && (devices [j - 1].addr_lim > addr_base))
+	|| ((j < n_devices) && (devices [j].addr_base < addr_lim))) {
+	const Device *other_p = (((j > 0) && (devices [j - 1].addr_lim > addr_base))
+				 ? & (devices [j - 1])
+				 : & (devices [j]));
+	fprintf (stdout, "ERROR: %s: device %s [0x%0" PRIx64 "..0x%0" PRIx64 ")",
+		 __FUNCTION__, name, addr_base, addr_lim);
+	fprintf (stdout, " overlaps device %s [0x%0" PRIx64 "..0x%0" PRIx64 ")\n",
+		 other_p->name, other_p->addr_base, other_p->addr_lim);
+	return 1;
+    }
+
+    memmove (& (devices [j + 1]), & (devices [j]), (n_devices - j) * sizeof (Device));
+    devices [j].name      = name;
+    devices [j].addr_base = addr_base;
+    devices [j].addr_lim  = addr_lim;
+    devices [j].dev_state = dev_state;
+    devices [j].access_fn = access_fn;
+    devices [j].tick_fn   = tick_fn;
+    devices [j].tick_idx  = -1;
+    n_devices++;
+    last_device_p = NULL;
+
+    if (tick_fn != NULL) {
+	// Due at the first tick
+	const int k = n_tickers;
+	tickers [k].dev_state = dev_state;
+	tickers [k].tick_fn   = tick_fn;
+	tickers [k].next_tick = 0;
+	tickers [k].heap_pos  = k;
+	heap [k] = k;
+	n_tickers++;
+	heap_sift_up (k);
+	devices [j].tick_idx = k;
+    }
+    return 0;
+}
+
+// ****************************************************************
+
+const Device *device_lookup (const uint64_t addr, const uint32_t size_B)
+{
+    const uint64_t addr_lim = addr + size_B;
+
+    Device *dev_p = last_device_p;
+    if ((dev_p != NULL) && (dev_p->addr_base <= addr) && (addr_lim <= dev_p->addr_lim))
+	return dev_p;
+
+    // Binary search for the last device with addr_base <= addr
+    int lo = 0;
+    int hi = n_devices;
+    while (lo < hi) {
+	const int mid = (lo + hi) / 2;
+	if (devices [mid].addr_base <= addr)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    if (lo == 0)
+	return NULL;
+
+    dev_p = & (devices [lo - 1]);
+    if (addr_lim > dev_p->addr_lim)
+	return NULL;
+
+    last_device_p = dev_p;
+    return dev_p;
+}
+
+// ****************************************************************
+
+uint64_t devices_tick (const uint64_t tick_num)
+{
+    cur_tick = tick_num;
+
+    while ((n_tickers != 0) && (tickers [heap [0]].next_tick <= tick_num)) {
+	Ticker *t_p = & (tickers [heap [0]]);
+	uint64_t next_tick = t_p->tick_fn (t_p->dev_state, tick_num);
+	if (next_tick <= tick_num)
+	    next_tick = tick_num + 1;
+	t_p->next_tick = next_tick;
+	heap_sift_down (0);
+    }
+    return irqs;
+}
+
+uint64_t devices_cur_tick (void)
+{
+    return cur_tick;
+}
+
+uint64_t devices_next_tick (void)
+{
+    return ((n_tickers == 0) ? DEVICE_TICK_NEVER : tickers [heap [0]].next_tick);
+}
+
+void device_wakeup (const Device *dev_p)
+{
+    if (dev_p->tick_idx < 0)
+	return;
+
+    Ticker *t_p = & (tickers [dev_p->tick_idx]);
+    if (t_p->next_tick > cur_tick + 1) {
+	t_p->next_tick = cur_tick + 1;
+	heap_sift_up (t_p->heap_pos);
+    }
+}
+
+// ****************************************************************
+
+void device_set_irq (const int irq_num, const bool level)
+{
+    const uint64_t mask = (1ull << irq_num);
+    irqs = (level ? (irqs | mask) : (irqs & (~ mask)));
+}
+
+// ****************************************************************
+
+void fprint_devices (FILE *fp)
+{
+    for (int j = 0; j < n_devices; j++) {
+	const Device *dev_p = & (devices [j]);
+	const uint64_t size_B = dev_p->addr_lim - dev_p->addr_base;
+	fprintf (fp, "   %-8s 0x%08" PRIx64 "..0x%08" PRIx64,
+		 dev_p->name, dev_p->addr_base, dev_p->addr_lim);
+	fprintf (fp, " (0x%08" PRIx64 " bytes)%s\n",
+		 size_B, ((dev_p->tick_fn != NULL) ? " tick" : ""));
+    }
+}
+
+// ****************************************************************
@@ -0,0 +1,117 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+#pragma once
+
+// ****************************************************************
+// Registry of memory-mapped devices (address regions) for the C
+// memory/devices model.
+// Each device occupies one address region [addr_base, addr_lim) and
+// supplies an access callback (for MMIO requests into its region)
+// and, optionally, a tick callback, so the device can run
+// "concurrently" with the system.
+// Tick callbacks are event-driven: each returns the tick at which it
+// next needs to be called, and devices_tick() only calls the devices
+// that are due.  When no device is due (the usual case), a tick costs
+// one comparison, however many devices there are.
+// Adding a device means registering a region; the decoder in
+// C_Mems_Devices.c does not change.
+
+// ****************************************************************
+// Device callbacks
+
+// Access: same arguments and result layout as c_mems_devices_req_rsp()
+// (result_p: 4 bytes of status followed by 8 bytes of read-data).
+// The request is guaranteed to lie entirely within the device's region.
+
+typedef void (*Device_Access_Fn) (void           *dev_state,
+				  uint8_t        *result_p,
+				  const uint64_t  inum,
+				  const uint32_t  req_type,
+				  const uint32_t  size_B,
+				  const uint64_t  addr,
+				  uint8_t        *wdata_p);
+
+// Tick: returns the tick at which the device next needs to be called
+// (> tick_num), or DEVICE_TICK_NEVER.  A device is also called at the
+// next tick after any access to it (see device_wakeup()), so state
+// changes from MMIO writes need not be predicted.
+
+typedef uint64_t (*Device_Tick_Fn) (void *dev_state, const uint64_t tick_num);
+
+#define DEVICE_TICK_NEVER  UINT64_MAX
+
+// ****************************************************************
+
+typedef struct {
+    const char       *name;
+    uint64_t          addr_base;
+    uint64_t          addr_lim;     // exclusive
+    void             *dev_state;
+    Device_Access_Fn  access_fn;
+    Device_Tick_Fn    tick_fn;      // may be NULL
+    int               tick_idx;     // index in the tick scheduler (if tick_fn)
+} Device;
+
+// ****************************************************************
+// Register a device.  Regions may not overlap.
+// Returns 0 if ok, non-zero on error (errors are reported on stdout).
+
+extern
+int device_register (const char             *name,
+		     const uint64_t          addr_base,
+		     const uint64_t          size_B,
+		     void                   *dev_state,
+		     const Device_Access_Fn  access_fn,
+		     const Device_Tick_Fn    tick_fn);
+
+// ****************************************************************
+// Find the device whose region contains [addr, addr + size_B).
+// Returns NULL if there is none.
+
+extern
+const Device *device_lookup (const uint64_t addr, const uint32_t size_B);
+
+// ****************************************************************
+// Call the tick callbacks of all devices that are due at tick_num.
+// Returns the current interrupt-request lines (see device_set_irq()).
+// The system need not call this every tick: only at ticks at or after
+// devices_next_tick(), and at the tick after any device access (see
+// device_wakeup()).  tick_num must not decrease from call to call.
+
+extern
+uint64_t devices_tick (const uint64_t tick_num);
+
+// ----------------
+// The earliest tick at which some device is due (DEVICE_TICK_NEVER if
+// none), as of the most recent devices_tick() or device_wakeup()
+
+extern
+uint64_t devices_next_tick (void);
+
+// ----------------
+// The tick_num of the most recent devices_tick()
+
+extern
+uint64_t devices_cur_tick (void);
+
+// ----------------
+// Schedule the device's tick callback for the next tick (e.g., after
+// an MMIO access that may have changed its state).
+
+extern
+void device_wakeup (const Device *dev_p);
+
+// ****************************************************************
+// Interrupt-request lines: a 64-bit vector, one bit per line, returned
+// by devices_tick().  The numbering is the system's (C_Mems_Devices.c
+// uses the bit positions of the RISC-V MIP CSR).
+
+extern
+void device_set_irq (const int irq_num, const bool level);
+
+// ****************************************************************
+
+extern
+void fprint_devices (FILE *fp);
+
+// ****************************************************************
@@ -0,0 +1,390 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Native ELF loader for the C memory model.
+// See Elf_Loader.h for the API.
+
+// Segment contents are pread() straight into the memory array (no
+// intermediate buffer, no text parsing).  Only the symbol table is
+// read into a temporary buffer, to look up 'tohost' and '_start' and
+// collect code symbols.
+
+// ****************************************************************
+// Includes from C lib
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <elf.h>
+
+// ----------------
+// Local includes
+
+#include "Elf_Loader.h"
+
+// ****************************************************************
+// ELF32 and ELF64 headers are normalized into these 64-bit versions
+
+typedef struct {
+    uint64_t  p_type;
+    uint64_t  p_offset;
+    uint64_t  p_paddr;
+    uint64_t  p_filesz;
+    uint64_t  p_memsz;
+} Phdr;
+
+typedef struct {
+    uint64_t  sh_type;
+    uint64_t  sh_offset;
+    uint64_t  sh_size;
+    uint64_t  sh_link;
+    uint64_t  sh_entsize;
+} Shdr;
+
+// ================================================================
+// Read exactly n bytes at file offset 'offset'; return 0 if ok
+
+static
+int pread_all (const int fd, void *buf, const uint64_t n, const uint64_t offset)
+{
+    uint8_t  *p      = (uint8_t *) buf;
+    uint64_t  n_done = 0;
+    while (n_done < n) {
+	ssize_t k = pread (fd, p + n_done, n - n_done, offset + n_done);
+	if ((k < 0) && (errno == EINTR)) continue;
+	if (k <= 0) return 1;
+	n_done += k;
+    }
+    return 0;
+}
+
+// ================================================================
+// Zero a range of mem_array.
+// Whole pages are handed back to the host (they read as zero again);
+// only the partial pages at either end are memset.
+
+static
+void zero_mem (uint8_t *p, const uint64_t n)
+{
+    const uintptr_t page_size = (uintptr_t) sysconf (_SC_PAGESIZE);
+    uintptr_t lo  = (uintptr_t) p;
+    uintptr_t hi  = lo + n;
+    uintptr_t lo2 = (lo + page_size - 1) & (~ (page_size - 1));
+    uintptr_t hi2 = hi & (~ (page_size - 1));
+
+    if (lo2 >= hi2) {
+	memset (p, 0, n);
+	return;
+    }
+    memset ((void *) lo, 0, lo2 - lo);
+    madvise ((void *) lo2, hi2 - lo2, MADV_DONTNEED);
+    memset ((void *) hi2, 0, hi - hi2);
+}
+
+// ================================================================
+// Look up 'tohost' and '_start' in the symbol table, if any, and
+// collect code symbols (defined STT_FUNC and STT_NOTYPE symbols, other
+// than mapping symbols such as '$x').
+
+static
+void find_symbols (const int         fd,
+		   const bool        is_64,
+		   const uint64_t    shoff,
+		   const uint64_t    shnum,
+		   Elf_Info         *info_p,
+		   const int         verbosity)
+{
+    const uint64_t shentsize = (is_64 ? sizeof (Elf64_Shdr) : sizeof (Elf32_Shdr));
+
+    // Read one section header (normalized)
+    Shdr symtab, strtab;
+    bool found = false;
+    for (uint64_t j = 0; j < shnum; j++) {
+	Shdr sh;
+	if (is_64) {
+	    Elf64_Shdr x;
+	    if (pread_all (fd, & x, sizeof (x), shoff + j * shentsize) != 0) return;
+	    sh = (Shdr) {x.sh_type, x.sh_offset, x.sh_size, x.sh_link, x.sh_entsize};
+	}
+	else {
+	    Elf32_Shdr x;
+	    if (pread_all (fd, & x, sizeof (x), shoff + j * shentsize) != 0) return;
+	    sh = (Shdr) {x.sh_type, x.sh_offset, x.sh_size, x.sh_link, x.sh_entsize};
+	}
+	if ((sh.sh_type == SHT_SYMTAB) && (sh.sh_link < shnum)) {
+	    symtab = sh;
+	    found  = true;
+	    break;
+	}
+    }
+    if (! found) {
+	if (verbosity != 0)
+	    fprintf (stdout, "    No symbol table\n");
+	return;
+    }
+
+    // The associated string table
+    if (is_64) {
+	Elf64_Shdr x;
+	if (pread_all (fd, & x, sizeof (x), shoff + symtab.sh_link * shentsize) != 0) return;
+	strtab = (Shdr) {x.sh_type, x.sh_offset, x.sh_size, x.sh_link, x.sh_entsize};
+    }
+    else {
+	Elf32_Shdr x;
+	if (pread_all (fd, & x, sizeof (x), shoff + symtab.sh_link * shentsize) != 0) return;
+	strtab = (Shdr) {x.sh_type, x.sh_offset, x.sh_size, x.sh_link, x.sh_entsize};
+    }
+
+    uint8_t *syms = (uint8_t *) malloc (symtab.sh_size);
+    char    *strs = (char *)    malloc (strtab.sh_size + 1);
+    if ((syms == NULL) || (strs == NULL)
+	|| (pread_all (fd, syms, symtab.sh_size, symtab.sh_offset) != 0)
+	|| (pread_all (fd, strs, strtab.sh_size, strtab.sh_offset) != 0)) {
+	fprintf (stdout, "WARNING: %s: unable to read symbol table\n", __FUNCTION__);
+	free (syms);
+	free (strs);
+	return;
+    }
+    strs [strtab.sh_size] = 0;
+
+    const uint64_t symentsize = (is_64 ? sizeof (Elf64_Sym) : sizeof (Elf32_Sym));
+    const uint64_t n_syms     = symtab.sh_size / symentsize;
+    info_p->syms = (Elf_Symbol *) malloc ((n_syms + 1) * sizeof (Elf_Symbol));
+    if (info_p->syms == NULL) {
+	fprintf (stdout, "WARNING: %s: unable to malloc symbols\n", __FUNCTION__);
+	free (syms);
+	free (strs);
+	return;
+    }
+    for (uint64_t j = 0; j < n_syms; j++) {
+	uint64_t st_name, st_value, st_size, st_type, st_shndx;
+	if (is_64) {
+	    Elf64_Sym *p = (Elf64_Sym *) (syms + j * symentsize);
+	    st_name  = p->st_name;
+	    st_value = p->st_value;
+	    st_size  = p->st_size;
+	    st_type  = ELF64_ST_TYPE (p->st_info);
+	    st_shndx = p->st_shndx;
+	}
+	else {
+	    Elf32_Sym *p = (Elf32_Sym *) (syms + j * symentsize);
+	    st_name  = p->st_name;
+	    st_value = p->st_value;
+	    st_size  = p->st_size;
+	    st_type  = ELF32_ST_TYPE (p->st_info);
+	    st_shndx = p->st_shndx;
+	}
+	if (st_name >= strtab.sh_size) continue;
+
+	const char *name = & (strs [st_name]);
+	if (strcmp (name, "tohost") == 0) {
+	    info_p->has_tohost  = true;
+	    info_p->addr_tohost = st_value;
+	}
+	else if (strcmp (name, "_start") == 0) {
+	    info_p->has_start  = true;
+	    info_p->addr_start = st_value;
+	}
+
+	if (((st_type == STT_FUNC) || (st_type == STT_NOTYPE))
+	    && (st_shndx != SHN_UNDEF) && (st_shndx < SHN_LORESERVE)
+	    && (name [0] != 0) && (name [0] != '$')) {
+	    Elf_Symbol *sym_p = & (info_p->syms [info_p->n_syms++]);
+	    sym_p->addr    = st_value;
+	    sym_p->size    = st_size;
+	    sym_p->is_func = (st_type == STT_FUNC);
+	    sym_p->name    = name;
+	}
+    }
+    free (syms);
+    info_p->sym_strs = strs;
+
+    if (verbosity != 0) {
+	if (info_p->has_start)
+	    fprintf (stdout, "    _start: 0x%08" PRIx64 "\n", info_p->addr_start);
+	if (info_p->has_tohost)
+	    fprintf (stdout, "    tohost: 0x%08" PRIx64 "\n", info_p->addr_tohost);
+    }
+}
+
+// ****************************************************************
+// Load an ELF file
+
+int load_elf (const char     *filename,
+	      uint8_t        *mem_array,
+	      const uint64_t  addr_base,
+	      const uint64_t  size_B,
+	      Elf_Info       *info_p,
+	      const int       verbosity)
+{
+    memset (info_p, 0, sizeof (Elf_Info));
+
+    int fd = open (filename, O_RDONLY);
+    if (fd < 0) {
+	fprintf (stdout, "ERROR: %s: unable to open ELF file %s\n", __FUNCTION__, filename);
+	return 1;
+    }
+
+    // ----------------
+    // ELF header
+
+    Elf64_Ehdr ehdr64;
+    Elf32_Ehdr ehdr32;
+    uint8_t    e_ident [EI_NIDENT];
+
+    if ((pread_all (fd, e_ident, EI_NIDENT, 0) != 0)
+	|| (memcmp (e_ident, ELFMAG, SELFMAG) != 0)) {
+	fprintf (stdout, "ERROR: %s: %s is not an ELF file\n", __FUNCTION__, filename);
+	close (fd);
+	return 1;
+    }
+    if (e_ident [EI_DATA] != ELFDATA2LSB) {
+	fprintf (stdout, "ERROR: %s: %s is not little-endian\n", __FUNCTION__, filename);
+	close (fd);
+	return 1;
+    }
+
+    const bool is_64 = (e_ident [EI_CLASS] == ELFCLASS64);
+    if ((! is_64) && (e_ident [EI_CLASS] != ELFCLASS32)) {
+	fprintf (stdout, "ERROR: %s: %s: unknown ELF class %0d\n",
+		 __FUNCTION__, filename, e_ident [EI_CLASS]);
+	close (fd);
+	return 1;
+    }
+
+    uint64_t e_machine, e_phoff, e_phnum, e_shoff, e_shnum;
+    int rc;
+    if (is_64) {
+	rc        = pread_all (fd, & ehdr64, sizeof (ehdr64), 0);
+	e_machine = ehdr64.e_machine;
+	e_phoff   = ehdr64.e_phoff;
+	e_phnum   = ehdr64.e_phnum;
+	e_shoff   = ehdr64.e_shoff;
+	e_shnum   = ehdr64.e_shnum;
+	info_p->entry = ehdr64.e_entry;
+    }
+    else {
+	rc        = pread_all (fd, & ehdr32, sizeof (ehdr32), 0);
+	e_machine = ehdr32.e_machine;
+	e_phoff   = ehdr32.e_phoff;
+	e_phnum   = ehdr32.e_phnum;
+	e_shoff   = ehdr32.e_shoff;
+	e_shnum   = ehdr32.e_shnum;
+	info_p->entry = ehdr32.e_entry;
+    }
+    if (rc != 0) {
+	fprintf (stdout, "ERROR: %s: %s: truncated ELF header\n", __FUNCTION__, filename);
+	close (fd);
+	return 1;
+    }
+    if (e_machine != EM_RISCV)
+	fprintf (stdout, "WARNING: %s: %s: e_machine is %0" PRId64 ", not RISC-V\n",
+		 __FUNCTION__, filename, e_machine);
+
+    if (verbosity != 0)
+	fprintf (stdout, "    ELF%0d, entry 0x%08" PRIx64 ", %0" PRId64 " program headers\n",
+		 (is_64 ? 64 : 32), info_p->entry, e_phnum);
+
+    // ----------------
+    // Program headers: load PT_LOAD segments
+
+    const uint64_t phentsize = (is_64 ? sizeof (Elf64_Phdr) : sizeof (Elf32_Phdr));
+    const uint64_t addr_lim  = addr_base + size_B;
+
+    for (uint64_t j = 0; j < e_phnum; j++) {
+	Phdr ph;
+	if (is_64) {
+	    Elf64_Phdr x;
+	    rc = pread_all (fd, & x, sizeof (x), e_phoff + j * phentsize);
+	    ph = (Phdr) {x.p_type, x.p_offset, x.p_paddr, x.p_filesz, x.p_memsz};
+	}
+	else {
+	    Elf32_Phdr x;
+	    rc = pread_all (fd, & x, sizeof (x), e_phoff + j * phentsize);
+	    ph = (Phdr) {x.p_type, x.p_offset, x.p_paddr, x.p_filesz, x.p_memsz};
+	}
+	if (rc != 0) {
+	    fprintf (stdout, "ERROR: %s: %s: truncated program header %0" PRId64 "\n",
+		     __FUNCTION__, filename, j);
+	    close (fd);
+	    return 1;
+	}
+	if ((ph.p_type != PT_LOAD) || (ph.p_memsz == 0)) continue;
+
+	uint64_t addr   = ph.p_paddr;
+	uint64_t offset = ph.p_offset;
+	uint64_t filesz = ph.p_filesz;
+	uint64_t memsz  = ph.p_memsz;
+
+	if (verbosity != 0)
+	    fprintf (stdout, "    PT_LOAD paddr 0x%08" PRIx64 " filesz 0x%0" PRIx64
+		     " memsz 0x%0" PRIx64 "\n", addr, filesz, memsz);
+
+	// Linkers often include the ELF headers in the first segment,
+	// below the program's first section; skip any such prefix that
+	// is below memory.
+	if (addr < addr_base) {
+	    uint64_t skip = addr_base - addr;
+	    if (skip >= memsz) {
+		fprintf (stdout, "WARNING: %s: segment at 0x%08" PRIx64 " is below mem; ignored\n",
+			 __FUNCTION__, addr);
+		continue;
+	    }
+	    if (verbosity != 0)
+		fprintf (stdout, "    (skipping 0x%0" PRIx64 " bytes below mem)\n", skip);
+	    addr   += skip;
+	    offset += skip;
+	    filesz  = ((filesz > skip) ? (filesz - skip) : 0);
+	    memsz  -= skip;
+	}
+	if ((addr + memsz) > addr_lim) {
+	    fprintf (stdout, "ERROR: %s: segment [0x%08" PRIx64 "..0x%08" PRIx64
+		     ") out of bounds\n", __FUNCTION__, addr, addr + memsz);
+	    fprintf (stdout, "       Mem is [0x%08" PRIx64 "..0x%08" PRIx64 ")\n",
+		     addr_base, addr_lim);
+	    close (fd);
+	    return 1;
+	}
+
+	uint8_t *p = & (mem_array [addr - addr_base]);
+	if ((filesz != 0) && (pread_all (fd, p, filesz, offset) != 0)) {
+	    fprintf (stdout, "ERROR: %s: %s: unable to read segment at 0x%08" PRIx64 "\n",
+		     __FUNCTION__, filename, addr);
+	    close (fd);
+	    return 1;
+	}
+	if (memsz > filesz)
+	    zero_mem (p + filesz, memsz - filesz);
+
+	info_p->n_bytes_loaded += filesz;
+    }
+
+    // ----------------
+    // Symbols
+
+    if ((e_shoff != 0) && (e_shnum != 0))
+	find_symbols (fd, is_64, e_shoff, e_shnum, info_p, verbosity);
+
+    close (fd);
+    return 0;
+}
+
+// ****************************************************************
+
+void free_elf_info (Elf_Info *info_p)
+{
+    free (info_p->syms);
+    free (info_p->sym_strs);
+    info_p->syms     = NULL;
+    info_p->n_syms   = 0;
+    info_p->sym_strs = NULL;
+}
+
+// ****************************************************************
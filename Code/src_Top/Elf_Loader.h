@@ -0,0 +1,62 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+#pragma once
+
+// ****************************************************************
+// Native ELF loader for the C memory model.
+// Loads PT_LOAD segments of an ELF32 or ELF64 (little-endian) file
+// directly into a memory array, at their physical (load) addresses.
+// No text parsing is involved (cf. memhex32 files).
+
+// ****************************************************************
+// Code symbols (STT_FUNC and STT_NOTYPE, e.g., assembler entry points),
+// for symbolizing PCs
+
+typedef struct {
+    uint64_t     addr;
+    uint64_t     size;           // 0 if unknown (usual for STT_NOTYPE)
+    bool         is_func;        // STT_FUNC
+    const char  *name;
+} Elf_Symbol;
+
+// ****************************************************************
+// Information gleaned from the ELF file while loading it
+
+typedef struct {
+    uint64_t  entry;             // e_entry from ELF header
+
+    bool      has_start;         // Symbol '_start' found
+    uint64_t  addr_start;
+
+    bool      has_tohost;        // Symbol 'tohost' found
+    uint64_t  addr_tohost;
+
+    uint64_t  n_bytes_loaded;    // Bytes copied from file into memory
+
+    Elf_Symbol *syms;            // Code symbols, in symbol-table order
+    uint64_t    n_syms;
+    char       *sym_strs;        // (string table; names point into it)
+} Elf_Info;
+
+// ****************************************************************
+// Load ELF file 'filename' into mem_array, which represents
+// addresses [addr_base, addr_base + size_B).
+// mem_array must be page-aligned anonymous memory (zero pages in
+// .bss segments are released back to the host, not just zeroed).
+// Returns 0 if ok, non-zero on error (errors are reported on stdout).
+
+extern
+int load_elf (const char     *filename,
+	      uint8_t        *mem_array,
+	      const uint64_t  addr_base,
+	      const uint64_t  size_B,
+	      Elf_Info       *info_p,
+	      const int       verbosity);
+
+// ----------------
+// Free the symbols in an Elf_Info filled in by load_elf()
+
+extern
+void free_elf_info (Elf_Info *info_p);
+
+// ****************************************************************
@@ -0,0 +1,454 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Loader for memhex32 files.
+// See Memhex_Loader.h for the API.
+
+// There are two versions:
+// * Serial: fgets() one line at a time (the original loader).
+// * Parallel: mmap the file, split it into chunks at line
+//     boundaries, and parse the chunks in parallel threads.
+
+// The parallel version makes three passes:
+//   1. (parallel) For each chunk, count data lines before its first
+//        '@' line, and note the address set by its last '@' line and
+//        the number of data lines after it.
+//   2. (serial)   From these, compute the starting address of each chunk.
+//   3. (parallel) Parse each chunk and write its data into memory.
+// It reproduces the serial loader exactly, including fgets()'s
+// splitting of lines longer than (LINEBUF_SIZE - 1) characters.  If
+// any two chunks write overlapping addresses (so that the order of
+// writes matters), the file is re-loaded serially.
+
+// ****************************************************************
+// Includes from C lib
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ----------------
+// Local includes
+
+#include "Memhex_Loader.h"
+
+// ****************************************************************
+
+#define LINEBUF_SIZE 256
+
+// Chunks smaller than this are not worth a thread
+#define MIN_CHUNK_SIZE_B  0x10000
+
+// ================================================================
+// Parse hex number allowing '_' and ' ' spacers
+
+static
+uint32_t parse_hex (const char *linebuf)
+{
+    int      j = 0;
+    uint32_t x = 0;
+    while (true) {
+	uint8_t ch = linebuf [j];
+	if      (('A' <= ch) && (ch <= 'F')) x = (x << 4) + (ch - 'A' + 10);
+	else if (('a' <= ch) && (ch <= 'f')) x = (x << 4) + (ch - 'a' + 10);
+	else if (('0' <= ch) && (ch <= '9')) x = (x << 4) + (ch - '0');
+	else if ((ch == ' ') || (ch == '_')) { } // skip
+	else                                 break;  // Done; ignore rest of line
+	j++;
+    }
+    return x;
+}
+
+// ****************************************************************
+// Serial loader
+
+static
+int load_memhex32_serial (FILE           *fp,
+			  uint8_t        *mem_array,
+			  const uint64_t  addr_base_mem,
+			  const uint64_t  size_B_mem,
+			  const int       verbosity)
+{
+    char linebuf [LINEBUF_SIZE];
+
+    int      line_num = 0;
+    uint64_t addr = 0;
+
+    while (true) {
+	char *p = fgets (linebuf, LINEBUF_SIZE, fp);
+	if (p == NULL) break;
+
+	line_num++;
+
+	if (linebuf [0] == '@') {
+	    addr = (parse_hex (& (linebuf [1])) << 2);
+	    if (verbosity > 0)
+		fprintf (stdout, "  Setting addr = 0x%08" PRIx64 "\n", addr);
+	}
+	else if (isxdigit (linebuf [0])) {
+	    uint32_t x = parse_hex (linebuf);
+	    if ((addr - addr_base_mem) > (size_B_mem - 4)) {
+		fprintf (stdout,
+			 "ERROR: load_memhex32(): addr 0x%08" PRIx64 " out of bounds\n", addr);
+		fprintf (stdout,
+			 "       Mem size is 0x%08" PRIx64 "\n", size_B_mem);
+		return 1;
+	    }
+	    memcpy (& (mem_array [addr - addr_base_mem]), & x, 4);
+	    if (verbosity > 1)
+		fprintf (stdout, "Loading mem [%08" PRIx64 "] <= %08x\n", addr, x);
+	    addr += 4;
+	}
+	else {
+	    // Ignore this line
+	}
+    }
+    return 0;
+}
+
+// ****************************************************************
+// Parallel loader
+
+// ================================================================
+// Table-driven hex decoding
+
+#define HEX_SKIP  0x10    // ' ' and '_' spacers
+#define HEX_END   0x11    // anything else ends the number
+
+static uint8_t hex_table [256];
+
+static
+void init_hex_table (void)
+{
+    for (int ch = 0; ch < 256; ch++) {
+	if      (('0' <= ch) && (ch <= '9')) hex_table [ch] = ch - '0';
+	else if (('A' <= ch) && (ch <= 'F')) hex_table [ch] = ch - 'A' + 10;
+	else if (('a' <= ch) && (ch <= 'f')) hex_table [ch] = ch - 'a' + 10;
+	else if ((ch == ' ') || (ch == '_')) hex_table [ch] = HEX_SKIP;
+	else                                 hex_table [ch] = HEX_END;
+    }
+}
+
+// Same result as parse_hex(), for the line [p, end)
+
+static inline
+uint32_t parse_hex_fast (const uint8_t *p, const uint8_t *end)
+{
+    // Common case: exactly 8 digits followed by a terminator
+    if ((end - p) > 8) {
+	const uint32_t d0 = hex_table [p [0]], d1 = hex_table [p [1]];
+	const uint32_t d2 = hex_table [p [2]], d3 = hex_table [p [3]];
+	const uint32_t d4 = hex_table [p [4]], d5 = hex_table [p [5]];
+	const uint32_t d6 = hex_table [p [6]], d7 = hex_table [p [7]];
+	if (((d0 | d1 | d2 | d3 | d4 | d5 | d6 | d7) < 0x10)
+	    && (hex_table [p [8]] == HEX_END))
+	    return ((d0 << 28) | (d1 << 24) | (d2 << 20) | (d3 << 16)
+		    | (d4 << 12) | (d5 << 8) | (d6 << 4) | d7);
+    }
+
+    uint32_t x = 0;
+    for (; p < end; p++) {
+	const uint8_t d = hex_table [*p];
+	if      (d < 0x10)      x = (x << 4) + d;
+	else if (d == HEX_END)  break;
+    }
+    return x;
+}
+
+// End of the line starting at p, as fgets() would read it:
+// through the next '\n', or (LINEBUF_SIZE - 1) chars, or end of chunk.
+
+static inline
+const uint8_t *line_end (const uint8_t *p, const uint8_t *hi)
+{
+    size_t n = hi - p;
+    if (n > (LINEBUF_SIZE - 1)) n = LINEBUF_SIZE - 1;
+    const uint8_t *q = (const uint8_t *) memchr (p, '\n', n);
+    return ((q != NULL) ? (q + 1) : (p + n));
+}
+
+// ================================================================
+// Per-chunk state
+
+// A run of consecutively-addressed words written by a chunk
+typedef struct {
+    uint64_t  addr_lo;
+    uint64_t  addr_hi;
+} Run;
+
+typedef struct {
+    const uint8_t  *lo;                 // [lo, hi) in the mmap'd file
+    const uint8_t  *hi;
+
+    // Pass 1 results
+    bool      has_at;
+    uint64_t  n_data_before_at;
+    uint64_t  addr_last_at;
+    uint64_t  n_data_after_at;
+
+    // Pass 2 result
+    uint64_t  addr_start;
+
+    // Pass 3 results
+    Run      *runs;
+    int       n_runs;
+    int       max_runs;
+    bool      err;
+    uint64_t  err_addr;
+
+    // Memory
+    uint8_t  *mem_array;
+    uint64_t  addr_base_mem;
+    uint64_t  size_B_mem;
+} Chunk;
+
+static
+void *pass1_count (void *arg)
+{
+    Chunk *c = (Chunk *) arg;
+    for (const uint8_t *p = c->lo; p < c->hi; ) {
+	const uint8_t *end = line_end (p, c->hi);
+	if (p [0] == '@') {
+	    c->has_at          = true;
+	    c->addr_last_at    = (uint32_t) (parse_hex_fast (p + 1, end) << 2);
+	    c->n_data_after_at = 0;
+	}
+	else if (hex_table [p [0]] < 0x10) {
+	    if (c->has_at) c->n_data_after_at++;
+	    else           c->n_data_before_at++;
+	}
+	p = end;
+    }
+    return NULL;
+}
+
+static
+void add_run (Chunk *c, const uint64_t addr_lo, const uint64_t addr_hi)
+{
+    if (addr_lo == addr_hi) return;
+    if (c->n_runs == c->max_runs) {
+	c->max_runs = ((c->max_runs == 0) ? 16 : (2 * c->max_runs));
+	c->runs     = (Run *) realloc (c->runs, c->max_runs * sizeof (Run));
+	if (c->runs == NULL) {
+	    fprintf (stdout, "INTERNAL ERROR: %s: realloc failed\n", __FUNCTION__);
+	    exit (1);
+	}
+    }
+    c->runs [c->n_runs].addr_lo = addr_lo;
+    c->runs [c->n_runs].addr_hi = addr_hi;
+    c->n_runs++;
+}
+
+static
+void *pass3_load (void *arg)
+{
+    Chunk    *c        = (Chunk *) arg;
+    uint64_t  addr     = c->addr_start;
+    uint64_t  run_addr = addr;
+
+    for (const uint8_t *p = c->lo; p < c->hi; ) {
+	const uint8_t *end = line_end (p, c->hi);
+	if (p [0] == '@') {
+	    add_run (c, run_addr, addr);
+	    addr     = (uint32_t) (parse_hex_fast (p + 1, end) << 2);
+	    run_addr = addr;
+	}
+	else if (hex_table [p [0]] < 0x10) {
+	    uint32_t x = parse_hex_fast (p, end);
+	    if ((addr - c->addr_base_mem) > (c->size_B_mem - 4)) {
+		c->err      = true;
+		c->err_addr = addr;
+		break;
+	    }
+	    memcpy (& (c->mem_array [addr - c->addr_base_mem]), & x, 4);
+	    addr += 4;
+	}
+	p = end;
+    }
+    add_run (c, run_addr, addr);
+    return NULL;
+}
+
+// Run fn on all chunks, chunk 0 in this thread, the rest in new threads
+
+static
+void run_chunks (Chunk *chunks, const int n_chunks, void *(*fn) (void *))
+{
+    pthread_t threads [n_chunks];
+    for (int j = 1; j < n_chunks; j++) {
+	if (pthread_create (& threads [j], NULL, fn, & chunks [j]) != 0) {
+	    fprintf (stdout, "ERROR: %s: pthread_create failed\n", __FUNCTION__);
+	    exit (1);
+	}
+    }
+    fn (& chunks [0]);
+    for (int j = 1; j < n_chunks; j++)
+	pthread_join (threads [j], NULL);
+}
+
+static
+int cmp_runs (const void *p1, const void *p2)
+{
+    const Run *r1 = (const Run *) p1;
+    const Run *r2 = (const Run *) p2;
+    return ((r1->addr_lo < r2->addr_lo) ? -1 : ((r1->addr_lo > r2->addr_lo) ? 1 : 0));
+}
+
+// Returns true if any two chunks wrote overlapping addresses
+
+static
+bool chunks_overlap (Chunk *chunks, const int n_chunks)
+{
+    int n_runs = 0;
+    for (int j = 0; j < n_chunks; j++)
+	n_runs += chunks [j].n_runs;
+
+    Run *runs = (Run *) malloc ((n_runs + 1) * sizeof (Run));
+    if (runs == NULL) return true;
+
+    int k = 0;
+    for (int j = 0; j < n_chunks; j++) {
+	memcpy (& (runs [k]), chunks [j].runs, chunks [j].n_runs * sizeof (Run));
+	k += chunks [j].n_runs;
+    }
+    qsort (runs, n_runs, sizeof (Run), cmp_runs);
+
+    bool overlap = false;
+    for (int j = 1; j < n_runs; j++)
+	if (runs [j - 1].addr_hi > runs [j].addr_lo) {
+	    overlap = true;
+	    break;
+	}
+    free (runs);
+    return overlap;
+}
+
+static
+int load_memhex32_parallel (const uint8_t  *buf,
+			    const uint64_t  size_B_file,
+			    uint8_t        *mem_array,
+			    const uint64_t  addr_base_mem,
+			    const uint64_t  size_B_mem,
+			    const int       n_threads,
+			    bool           *overlap_p)
+{
+    init_hex_table ();
+
+    int n_chunks = n_threads;
+    if (n_chunks > ((size_B_file / MIN_CHUNK_SIZE_B) + 1))
+	n_chunks = (size_B_file / MIN_CHUNK_SIZE_B) + 1;
+
+    Chunk *chunks = (Chunk *) calloc (n_chunks, sizeof (Chunk));
+    if (chunks == NULL) {
+	fprintf (stdout, "INTERNAL ERROR: %s: calloc failed\n", __FUNCTION__);
+	exit (1);
+    }
+
+    // Split into chunks at line boundaries
+    const uint8_t *file_end = buf + size_B_file;
+    const uint8_t *p        = buf;
+    for (int j = 0; j < n_chunks; j++) {
+	const uint8_t *q = buf + ((size_B_file * (j + 1)) / n_chunks);
+	if (q < p) q = p;
+	if (q < file_end) {
+	    const uint8_t *nl = (const uint8_t *) memchr (q, '\n', file_end - q);
+	    q = ((nl == NULL) ? file_end : (nl + 1));
+	}
+	chunks [j].lo            = p;
+	chunks [j].hi            = ((j == (n_chunks - 1)) ? file_end : q);
+	chunks [j].mem_array     = mem_array;
+	chunks [j].addr_base_mem = addr_base_mem;
+	chunks [j].size_B_mem    = size_B_mem;
+	p = chunks [j].hi;
+    }
+
+    // Pass 1
+    run_chunks (chunks, n_chunks, pass1_count);
+
+    // Pass 2
+    uint64_t addr = 0;
+    for (int j = 0; j < n_chunks; j++) {
+	Chunk *c = & (chunks [j]);
+	c->addr_start = addr;
+	if (c->has_at)
+	    addr = c->addr_last_at + 4 * c->n_data_after_at;
+	else
+	    addr = addr + 4 * c->n_data_before_at;
+    }
+
+    // Pass 3
+    run_chunks (chunks, n_chunks, pass3_load);
+
+    int rc = 0;
+    for (int j = 0; j < n_chunks; j++)
+	if (chunks [j].err) {
+	    fprintf (stdout,
+		     "ERROR: load_memhex32(): addr 0x%08" PRIx64 " out of bounds\n",
+		     chunks [j].err_addr);
+	    fprintf (stdout,
+		     "       Mem size is 0x%08" PRIx64 "\n", size_B_mem);
+	    rc = 1;
+	    break;
+	}
+
+    *overlap_p = ((rc == 0) && chunks_overlap (chunks, n_chunks));
+
+    for (int j = 0; j < n_chunks; j++)
+	free (chunks [j].runs);
+    free (chunks);
+    return rc;
+}
+
+// ****************************************************************
+// Load a memhex32 file
+
+int load_memhex32 (const char     *filename,
+		   uint8_t        *mem_array,
+		   const uint64_t  addr_base,
+		   const uint64_t  size_B,
+		   const int       n_threads,
+		   const int       verbosity,
+		   uint64_t       *n_bytes_p)
+{
+    *n_bytes_p = 0;
+
+    FILE *fp = fopen (filename, "r");
+    if (fp == NULL) {
+	fprintf (stdout, "Unable to open memhex file; ignoring; mem is not initialized\n");
+	return 0;
+    }
+
+    struct stat st;
+    if (fstat (fileno (fp), & st) == 0)
+	*n_bytes_p = st.st_size;
+
+    // The parallel loader does not print per-line verbose messages
+    int  rc      = 0;
+    bool overlap = true;
+    if ((n_threads > 1) && (verbosity == 0) && (*n_bytes_p != 0)) {
+	void *buf = mmap (NULL, *n_bytes_p, PROT_READ, MAP_PRIVATE, fileno (fp), 0);
+	if (buf != MAP_FAILED) {
+	    madvise (buf, *n_bytes_p, MADV_SEQUENTIAL);
+	    rc = load_memhex32_parallel ((const uint8_t *) buf, *n_bytes_p,
+					 mem_array, addr_base, size_B,
+					 n_threads, & overlap);
+	    munmap (buf, *n_bytes_p);
+	}
+    }
+    if ((rc == 0) && overlap)
+	rc = load_memhex32_serial (fp, mem_array, addr_base, size_B, verbosity);
+
+    fclose (fp);
+    return rc;
+}
+
+// ****************************************************************
@@ -0,0 +1,27 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+#pragma once
+
+// ****************************************************************
+// Loader for memhex32 files (Verilog hex memory files with 32-bit
+// words, '@' lines giving word addresses).
+
+// ****************************************************************
+// Load memhex32 file 'filename' into mem_array, which represents
+// addresses [addr_base, addr_base + size_B).
+// If n_threads > 1, the file is mmap'd and parsed in parallel; the
+// resulting memory contents are identical to the serial loader's.
+// *n_bytes_p is set to the size of the file.
+// Returns 0 if ok (or if the file cannot be opened; then mem is not
+// initialized), non-zero on error (errors are reported on stdout).
+
+extern
+int load_memhex32 (const char     *filename,
+		   uint8_t        *mem_array,
+		   const uint64_t  addr_base,
+		   const uint64_t  size_B,
+		   const int       n_threads,
+		   const int       verbosity,
+		   uint64_t       *n_bytes_p);
+
+// ****************************************************************
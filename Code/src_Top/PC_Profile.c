@@ -0,0 +1,478 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Guest PC sampling profiler (see PC_Profile.h)
+
+// Env variables:
+//     PC_PROFILE=<prefix>          enables profiling; at exit, writes
+//         <prefix>.flat.txt    samples per function, and the hottest PCs
+//         <prefix>.folded      one line per distinct call stack:
+//                              "outer;...;inner <samples>" (input for
+//                              flamegraph.pl, speedscope, ...)
+//     PC_PROFILE_INTERVAL=<n>      ticks (cycles) between samples (default 1000)
+
+// A sample is the PC of the first instruction fetch at or after each
+// sample tick.  Samples are counted in a hash table keyed by PC; the
+// flat profile is computed from it at exit.
+
+// Call stacks come from a shadow stack, since the C model sees only
+// fetches: each fetched JAL/JALR that links to ra or t0 (x1 or x5, the
+// RISC-V calling convention) pushes its return address, and a fetch
+// that does not follow on from the previous one, to one of the return
+// addresses in the stack, pops back to it.  This is a heuristic: in
+// Fife, wrong-path (speculative) fetches can push frames that are only
+// popped when an outer function returns, and longjmp-like control flow
+// or context switches (FreeRTOS) leave stale frames until a return
+// address matches.  Each sample's stack is symbolized when it is
+// taken, and counted in a second hash table keyed by the folded line.
+
+// Only sampling ticks do any real work; other fetches cost a few
+// compares (plus a stack search at discontinuities).
+
+// ****************************************************************
+// Includes from C lib
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+// ----------------
+// Local includes
+
+#include "Elf_Loader.h"
+#include "PC_Profile.h"
+
+// ****************************************************************
+
+#define DEFAULT_INTERVAL  1000
+#define MAX_DEPTH          128
+#define MAX_FOLDED_LEN    4096
+#define N_HOT_PCS           30
+
+static const char *prefix           = NULL;
+static uint64_t    interval         = DEFAULT_INTERVAL;
+static uint64_t    next_sample_tick = 0;
+static uint64_t    n_samples        = 0;
+
+// ----------------
+// Symbols, sorted by address (at the first sample)
+
+static Elf_Symbol *syms       = NULL;
+static uint64_t    n_syms     = 0;
+static uint64_t    max_syms   = 0;
+static bool        syms_dirty = false;
+
+// ----------------
+// Shadow call stack of return addresses
+
+static uint64_t stack_ret [MAX_DEPTH];
+static int      depth       = 0;
+static uint64_t prev_pc     = 0;
+static uint64_t n_overflows = 0;
+
+// ----------------
+// Hash tables (open addressing, power-of-2 sizes, at most half full)
+
+typedef struct {
+    uint64_t  pc;
+    uint64_t  count;       // 0: empty slot
+} PC_Count;
+
+typedef struct {
+    char     *folded;      // NULL: empty slot
+    uint64_t  hash;
+    uint64_t  count;
+} Stack_Count;
+
+static PC_Count    *pc_counts       = NULL;
+static uint64_t     size_pc_counts  = 0;
+static uint64_t     n_pc_counts     = 0;
+
+static Stack_Count *stack_counts      = NULL;
+static uint64_t     size_stack_counts = 0;
+static uint64_t     n_stack_counts    = 0;
+
+// ****************************************************************
+// Symbolization
+
+static
+int cmp_syms (const void *a, const void *b)
+{
+    const Elf_Symbol *sa = (const Elf_Symbol *) a;
+    const Elf_Symbol *sb = (const Elf_Symbol *) b;
+    if (sa->addr != sb->addr)
+	return ((sa->addr < sb->addr) ? -1 : 1);
+    // At the same address, STT_FUNC last, so that lookup prefers it
+    return ((int) sa->is_func) - ((int) sb->is_func);
+}
+
+// The symbol for pc, or NULL if none
+
+static
+const Elf_Symbol *lookup_sym (const uint64_t pc)
+{
+    if (syms_dirty) {
+	qsort (syms, n_syms, sizeof (Elf_Symbol), cmp_syms);
+	syms_dirty = false;
+    }
+
+    // Last symbol with addr <= pc
+    uint64_t lo = 0, hi = n_syms;
+    while (lo < hi) {
+	const uint64_t mid = lo + ((hi - lo) / 2);
+	if (syms [mid].addr <= pc)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    if (lo == 0)
+	return NULL;
+    const Elf_Symbol *sym_p = & (syms [lo - 1]);
+    if ((sym_p->size != 0) && (pc >= (sym_p->addr + sym_p->size)))
+	return NULL;
+    return sym_p;
+}
+
+static
+const char *sym_name (const uint64_t pc)
+{
+    const Elf_Symbol *sym_p = lookup_sym (pc);
+    return ((sym_p == NULL) ? "[unknown]" : sym_p->name);
+}
+
+// ****************************************************************
+// Hash tables
+
+static
+void *calloc_or_die (const uint64_t n, const size_t size_B)
+{
+    void *p = calloc (n, size_B);
+    if (p == NULL) {
+	fprintf (stdout, "ERROR: PC profile: unable to calloc %0" PRIu64 " entries\n", n);
+	exit (1);
+    }
+    return p;
+}
+
+static
+uint64_t hash_u64 (uint64_t x)
+{
+    x ^= (x >> 33);
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= (x >> 33);
+    return x;
+}
+
+static
+uint64_t hash_str (const char *s)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;    // FNV-1a
+    for (; *s != 0; s++)
+	h = (h ^ (uint8_t) *s) * 0x100000001b3ULL;
+    return h;
+}
+
+static
+void pc_counts_incr (const uint64_t pc)
+{
+    if (2 * (n_pc_counts + 1) > size_pc_counts) {
+	PC_Count *old      = pc_counts;
+	uint64_t  old_size = size_pc_counts;
+	size_pc_counts = ((old_size == 0) ? 1024 : (2 * old_size));
+	pc_counts      = (PC_Count *) calloc_or_die (size_pc_counts, sizeof (PC_Count));
+	for (uint64_t j = 0; j < old_size; j++) {
+	    if (old [j].count == 0) continue;
+	    uint64_t k = hash_u64 (old [j].pc) & (size_pc_counts - 1);
+	    while (pc_counts [k].count != 0)
+		k = (k + 1) & (size_pc_counts - 1);
+	    pc_counts [k] = old [j];
+	}
+	free (old);
+    }
+
+    uint64_t k = hash_u64 (pc) & (size_pc_counts - 1);
+    while ((pc_counts [k].count != 0) && (pc_counts [k].pc != pc))
+	k = (k + 1) & (size_pc_counts - 1);
+    if (pc_counts [k].count == 0) {
+	pc_counts [k].pc = pc;
+	n_pc_counts++;
+    }
+    pc_counts [k].count++;
+}
+
+static
+void stack_counts_incr (const char *folded)
+{
+    if (2 * (n_stack_counts + 1) > size_stack_counts) {
+	Stack_Count *old      = stack_counts;
+	uint64_t     old_size = size_stack_counts;
+	size_stack_counts = ((old_size == 0) ? 1024 : (2 * old_size));
+	stack_counts      = (Stack_Count *) calloc_or_die (size_stack_counts, sizeof (Stack_Count));
+	for (uint64_t j = 0; j < old_size; j++) {
+	    if (old [j].folded == NULL) continue;
+	    uint64_t k = old [j].hash & (size_stack_counts - 1);
+	    while (stack_counts [k].folded != NULL)
+		k = (k + 1) & (size_stack_counts - 1);
+	    stack_counts [k] = old [j];
+	}
+	free (old);
+    }
+
+    const uint64_t h = hash_str (folded);
+    uint64_t k = h & (size_stack_counts - 1);
+    while ((stack_counts [k].folded != NULL)
+	   && ((stack_counts [k].hash != h) || (strcmp (stack_counts [k].folded, folded) != 0)))
+	k = (k + 1) & (size_stack_counts - 1);
+    if (stack_counts [k].folded == NULL) {
+	stack_counts [k].folded = strdup (folded);
+	stack_counts [k].hash   = h;
+	if (stack_counts [k].folded == NULL) {
+	    fprintf (stdout, "ERROR: PC profile: unable to strdup stack\n");
+	    exit (1);
+	}
+	n_stack_counts++;
+    }
+    stack_counts [k].count++;
+}
+
+// ****************************************************************
+// Take a sample
+
+static
+void append_frame (char *buf, size_t *len_p, const char *name)
+{
+    const size_t n = strlen (name);
+    if ((*len_p + n + 2) > MAX_FOLDED_LEN)
+	return;
+    if (*len_p != 0)
+	buf [(*len_p)++] = ';';
+    memcpy (buf + *len_p, name, n);
+    *len_p += n;
+    buf [*len_p] = 0;
+}
+
+static
+void take_sample (const uint64_t pc)
+{
+    n_samples++;
+    pc_counts_incr (pc);
+
+    // Outermost first: the function of each call site (return address - 4)
+    char   folded [MAX_FOLDED_LEN];
+    size_t len = 0;
+    folded [0] = 0;
+    for (int j = 0; j < depth; j++)
+	append_frame (folded, & len, sym_name (stack_ret [j] - 4));
+    append_frame (folded, & len, sym_name (pc));
+    stack_counts_incr (folded);
+}
+
+// ****************************************************************
+// Write the profiles at exit
+
+typedef struct {
+    const char *name;
+    uint64_t    count;
+} Name_Count;
+
+static
+int cmp_name_counts (const void *a, const void *b)
+{
+    const Name_Count *na = (const Name_Count *) a;
+    const Name_Count *nb = (const Name_Count *) b;
+    if (na->count != nb->count)
+	return ((na->count > nb->count) ? -1 : 1);
+    return strcmp (na->name, nb->name);
+}
+
+static
+int cmp_pc_counts (const void *a, const void *b)
+{
+    const PC_Count *pa = (const PC_Count *) a;
+    const PC_Count *pb = (const PC_Count *) b;
+    if (pa->count != pb->count)
+	return ((pa->count > pb->count) ? -1 : 1);
+    return ((pa->pc < pb->pc) ? -1 : (pa->pc > pb->pc));
+}
+
+static
+FILE *open_output (const char *suffix, char *filename, const size_t size)
+{
+    snprintf (filename, size, "%s%s", prefix, suffix);
+    FILE *fp = fopen (filename, "w");
+    if (fp == NULL)
+	fprintf (stdout, "WARNING: PC profile: unable to open %s\n", filename);
+    return fp;
+}
+
+static
+void write_flat (void)
+{
+    char  filename [1024];
+    FILE *fp = open_output (".flat.txt", filename, sizeof (filename));
+    if (fp == NULL)
+	return;
+
+    // Compact the PC table, and sort it by count
+    uint64_t n = 0;
+    for (uint64_t j = 0; j < size_pc_counts; j++)
+	if (pc_counts [j].count != 0)
+	    pc_counts [n++] = pc_counts [j];
+    qsort (pc_counts, n, sizeof (PC_Count), cmp_pc_counts);
+    size_pc_counts = 0;    // (no longer a hash table)
+
+    // Samples per function: PCs are sorted by count, not address, so
+    // accumulate in a table of (name, count), one entry per symbol
+    Name_Count *funcs   = (Name_Count *) calloc_or_die (n + 1, sizeof (Name_Count));
+    uint64_t    n_funcs = 0;
+    for (uint64_t j = 0; j < n; j++) {
+	const char *name = sym_name (pc_counts [j].pc);
+	uint64_t k;
+	for (k = 0; k < n_funcs; k++)
+	    if (funcs [k].name == name)
+		break;
+	if (k == n_funcs) {
+	    funcs [k].name = name;
+	    n_funcs++;
+	}
+	funcs [k].count += pc_counts [j].count;
+    }
+    qsort (funcs, n_funcs, sizeof (Name_Count), cmp_name_counts);
+
+    const double pct = ((n_samples == 0) ? 0.0 : (100.0 / n_samples));
+    fprintf (fp, "# PC profile: %0" PRIu64 " samples, one every %0" PRIu64 " ticks\n",
+	     n_samples, interval);
+    if (n_overflows != 0)
+	fprintf (fp, "# (shadow call stack overflowed %0" PRIu64 " times; depth %0d)\n",
+		 n_overflows, MAX_DEPTH);
+    fprintf (fp, "\n# Samples per function\n");
+    fprintf (fp, "#     %%    samples  function\n");
+    for (uint64_t k = 0; k < n_funcs; k++)
+	fprintf (fp, "%7.2f %10" PRIu64 "  %s\n", funcs [k].count * pct, funcs [k].count, funcs [k].name);
+
+    fprintf (fp, "\n# Hottest PCs\n");
+    fprintf (fp, "#     %%    samples  pc        function+offset\n");
+    for (uint64_t j = 0; (j < n) && (j < N_HOT_PCS); j++) {
+	const uint64_t    pc    = pc_counts [j].pc;
+	const Elf_Symbol *sym_p = lookup_sym (pc);
+	fprintf (fp, "%7.2f %10" PRIu64 "  %08" PRIx64, pc_counts [j].count * pct, pc_counts [j].count, pc);
+	if (sym_p != NULL)
+	    fprintf (fp, "  %s+0x%0" PRIx64, sym_p->name, pc - sym_p->addr);
+	fprintf (fp, "\n");
+    }
+
+    fclose (fp);
+    free (funcs);
+    fprintf (stdout, "    %s: %0" PRIu64 " functions, %0" PRIu64 " distinct PCs\n",
+	     filename, n_funcs, n);
+}
+
+static
+void write_folded (void)
+{
+    char  filename [1024];
+    FILE *fp = open_output (".folded", filename, sizeof (filename));
+    if (fp == NULL)
+	return;
+    for (uint64_t j = 0; j < size_stack_counts; j++)
+	if (stack_counts [j].folded != NULL)
+	    fprintf (fp, "%s %0" PRIu64 "\n", stack_counts [j].folded, stack_counts [j].count);
+    fclose (fp);
+    fprintf (stdout, "    %s: %0" PRIu64 " distinct stacks\n", filename, n_stack_counts);
+}
+
+static
+void pc_profile_write_at_exit (void)
+{
+    fprintf (stdout, "INFO: PC profile: %0" PRIu64 " samples\n", n_samples);
+    write_folded ();
+    write_flat ();
+}
+
+// ****************************************************************
+// ****************************************************************
+// ****************************************************************
+// Extern functions (see PC_Profile.h)
+
+bool pc_profile_init (void)
+{
+    prefix = getenv ("PC_PROFILE");
+    if (prefix == NULL)
+	return false;
+
+    const char *s = getenv ("PC_PROFILE_INTERVAL");
+    if (s != NULL) {
+	interval = strtoull (s, NULL, 0);
+	if (interval == 0) {
+	    fprintf (stdout, "ERROR: PC_PROFILE_INTERVAL should be > 0: %s\n", s);
+	    exit (1);
+	}
+    }
+
+    fprintf (stdout, "PC profile will be written to %s.flat.txt and %s.folded\n", prefix, prefix);
+    fprintf (stdout, "    one sample every %0" PRIu64 " ticks\n", interval);
+    atexit (pc_profile_write_at_exit);
+    return true;
+}
+
+// ================================================================
+
+void pc_profile_add_symbols (const Elf_Symbol *new_syms, const uint64_t n_new_syms)
+{
+    if (prefix == NULL)
+	return;
+
+    if (n_syms + n_new_syms > max_syms) {
+	max_syms = n_syms + n_new_syms;
+	syms = (Elf_Symbol *) realloc (syms, max_syms * sizeof (Elf_Symbol));
+	if (syms == NULL) {
+	    fprintf (stdout, "ERROR: %s: unable to realloc symbols\n", __FUNCTION__);
+	    exit (1);
+	}
+    }
+    for (uint64_t j = 0; j < n_new_syms; j++) {
+	syms [n_syms]      = new_syms [j];
+	syms [n_syms].name = strdup (new_syms [j].name);
+	if (syms [n_syms].name == NULL) {
+	    fprintf (stdout, "ERROR: %s: unable to strdup symbol\n", __FUNCTION__);
+	    exit (1);
+	}
+	n_syms++;
+    }
+    syms_dirty = true;
+}
+
+// ================================================================
+
+void pc_profile_fetch (const uint64_t pc, const uint32_t instr, const uint64_t tick)
+{
+    // A discontinuity to a return address in the stack is a return
+    if ((depth != 0) && (pc != (prev_pc + 4))) {
+	for (int j = depth - 1; j >= 0; j--)
+	    if (stack_ret [j] == pc) {
+		depth = j;
+		break;
+	    }
+    }
+    prev_pc = pc;
+
+    if (__builtin_expect (tick >= next_sample_tick, 0)) {
+	take_sample (pc);
+	next_sample_tick = tick + interval;
+    }
+
+    // JAL/JALR linking to ra or t0 is a call
+    const uint32_t opcode = (instr & 0x7F);
+    const uint32_t rd     = ((instr >> 7) & 0x1F);
+    if (((opcode == 0x6F) || (opcode == 0x67)) && ((rd == 1) || (rd == 5))) {
+	if (depth < MAX_DEPTH)
+	    stack_ret [depth++] = pc + 4;
+	else
+	    n_overflows++;
+    }
+}
+
+// ****************************************************************
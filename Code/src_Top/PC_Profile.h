@@ -0,0 +1,33 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+#pragma once
+
+// ****************************************************************
+// Guest PC sampling profiler for the C memory model.
+// Samples the instruction-fetch PC every PC_PROFILE_INTERVAL ticks
+// (cycles), and at exit writes a flat profile and a folded-stack file
+// (for flamegraph.pl and similar tools), symbolized with the ELF
+// files' symbols.  See PC_Profile.c for details.
+
+// ****************************************************************
+// Reads env variables PC_PROFILE and PC_PROFILE_INTERVAL.
+// Returns true if profiling is enabled.
+
+extern
+bool pc_profile_init (void);
+
+// ----------------
+// Add code symbols (e.g., from each ELF file loaded); copied, so the
+// caller may free them.  Ignored if profiling is not enabled.
+
+extern
+void pc_profile_add_symbols (const Elf_Symbol *syms, const uint64_t n_syms);
+
+// ----------------
+// Called for every instruction fetch (that got a response) from IMem,
+// with the current tick
+
+extern
+void pc_profile_fetch (const uint64_t pc, const uint32_t instr, const uint64_t tick);
+
+// ****************************************************************
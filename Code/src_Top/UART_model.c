@@ -6,6 +6,11 @@
 
 // ****************************************************************
 
+// For posix_openpt(), ptsname(), cfmakeraw()
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -13,7 +18,16 @@
 #include <string.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <poll.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "UART_model.h"
 
@@ -54,6 +68,23 @@ const uint8_t  uart_iir_rda   = 0x04;     // Received Data Available
 const uint8_t  uart_iir_cti   = 0x0C;     // Character Timeout Indication
 const uint8_t  uart_iir_thre  = 0x02;     // Transmitter Holding Register Empty
 const uint8_t  uart_iir_ms    = 0x00;     // Modem Status
+const uint8_t  uart_iir_fifos = 0xC0;     // FIFOs enabled (bits 7:6)
+
+// Bit fields of FCR (FIFO control reg)
+const uint8_t  uart_fcr_fifo_enable = 0x01;     // Enable TX and RX FIFOs
+const uint8_t  uart_fcr_rx_reset    = 0x02;     // Clear RX FIFO (self-clearing)
+const uint8_t  uart_fcr_tx_reset    = 0x04;     // Clear TX FIFO (self-clearing)
+const uint8_t  uart_fcr_rx_trigger  = 0xC0;     // RX trigger level: 1, 4, 8, 14 chars
+
+// Depth of the 16550 TX/RX FIFOs, as seen by the CPU
+#define UART_FIFO_DEPTH  16
+
+// Max number of unread input chars saved in a checkpoint
+#define UART_CKPT_RX_MAX  256
+
+// Character time (in ticks) for the RX character-timeout interrupt,
+// which is raised after 4 character times without RX activity.
+#define UART_CHAR_TIME_TICKS  1000
 
 // Bit fields of LCR
 const uint8_t  uart_lcr_dlab  = 0x80;     // Divisor latch access bit
@@ -77,15 +108,12 @@ const uint8_t  uart_lsr_dr    = 0x01;    // Data Ready
 const uint8_t  uart_lsr_reset_value = (uart_lsr_temt | uart_lsr_thre);
 
 // ****************************************************************
-// In the 'tick' function below, we poll for UART input relatively
-// infrequently; specifically, when tick_num & mask == 0.
-
-// WARNING: Linux boot seems quite sensitive to this frequency.  If
-// too small, Linux seems to drop UART chars, miss UART interrupts,
-// etc.  Of course, if too big, there may be noticeable latency in
-// providing input to Linux.
-
-#define UART_INPUT_POLL_FREQUENCY_MASK  0x3FFFF
+// Input chars (keyboard -> UART) are read by a background RX thread,
+// which blocks on the input file descriptor and deposits chars into
+// the RX FIFO as soon as they arrive.  The simulation thread only
+// inspects the FIFO's (atomic) head/tail when the CPU reads LSR, IIR
+// or RBR, and at tick() (for the interrupt level and the character
+// timeout), so there is no polling of the input fd.
 
 // ****************************************************************
 
@@ -112,21 +140,700 @@ struct UART_16550_struct {
     // To detect posedge of irq
     bool last_irq;
 
-    // Buffer for input chars (keyboard -> UART -> CPU)
-#define IN_LINEBUF_SIZE 128
-    char     in_linebuf [IN_LINEBUF_SIZE];
-    int      in_linebuf_len;
-    int      in_linebuf_next;
-
-    // Buffer for output chars (CPU -> UART -> screen)
-#define OUT_LINEBUF_SIZE 128
-    uint8_t out_linebuf [OUT_LINEBUF_SIZE];
-    int     out_linebuf_next;
-    int     out_linebuf_update_tick;
+    // THRE interrupt: raised when the TX holding reg/FIFO becomes empty
+    // after THR writes (or when enabled while empty); cleared by
+    // writing THR or by reading IIR when it reports THRE.
+    bool thre_ip;
+    bool tx_armed;    // THR written since thre_ip was last raised
+
+    // For the RX character-timeout interrupt
+    uint64_t cur_tick;            // latest tick_num given to tick()
+    uint64_t rx_seen_head;        // rx_head at last RX activity
+    uint64_t rx_activity_tick;    // tick of last RX activity (char in or out)
+
+    // RX FIFO for input chars (keyboard -> UART -> CPU).
+    // Single-producer (RX thread, rx_head) single-consumer (simulation
+    // thread, rx_tail) lock-free ring; free-running counters.
+    uint8_t         *rx_fifo;
+    uint64_t         rx_fifo_size;    // power of 2
+    uint64_t         rx_head;
+    uint64_t         rx_tail;
+    pthread_t        rx_thread;
+
+    // Unread input chars restored from a checkpoint; the CPU reads
+    // these before any in the RX FIFO (simulation thread only)
+    uint8_t          rx_restored [UART_CKPT_RX_MAX];
+    uint32_t         rx_restored_n;
+    uint32_t         rx_restored_next;
+
+    // Backend (the "serial line"): see UART_Backend below
+    int              backend;
+    int              rx_fd;           // -1 if none
+    int              tx_fd;           // -1 if none (or not yet connected)
+    int              listen_fd;       // UART_BACKEND_UNIX only
+    int              tx_fd_retired;   // UART_BACKEND_UNIX only: shut down
+                                      // by RX thread, to be closed by TX
+                                      // thread (-1 if none)
+    bool             tx_drop_when_full;
+    uint64_t         tx_n_dropped;
+
+    // Transmit ring for output chars (CPU -> UART -> screen).
+    // Single-producer (simulation thread, tx_head) single-consumer
+    // (writer thread, tx_tail) lock-free ring; head and tail are
+    // free-running counters.  The mutex/cond are only used to wake
+    // the writer thread when it is sleeping on an empty ring.
+    uint8_t         *tx_ring;
+    uint64_t         tx_ring_size;    // power of 2
+    uint64_t         tx_head;
+    uint64_t         tx_tail;
+    bool             tx_writer_sleeping;
+    bool             tx_stop;
+    pthread_t        tx_thread;
+    pthread_mutex_t  tx_mutex;
+    pthread_cond_t   tx_cond;
 };
 
+// ****************************************************************
+// UART backends (the "serial line"), selected by env variable
+// UART_BACKEND when the UART is created:
+//     stdio                       keyboard/screen (default)
+//     pty                         a pseudo-terminal; its name is printed
+//     unix:<path>                 a Unix-domain socket (listening) at <path>
+//     file:<capture>[,<replay>]   output to file <capture>; input
+//                                 replayed from file <replay>, if given
+// All backend I/O is done by the RX/TX threads (never by the
+// simulation thread), on non-blocking fds except for stdio, whose fds
+// are shared with the shell.  For pty and unix, which may have
+// no reader attached, output is dropped (and counted) when the TX ring
+// is full, rather than stalling the simulation.
+
+typedef enum {UART_BACKEND_STDIO,
+	      UART_BACKEND_PTY,
+	      UART_BACKEND_UNIX,
+	      UART_BACKEND_FILE} UART_Backend;
+
+#define BACKEND_POLL_TIMEOUT_MS  100
+
+static
+void set_nonblocking (const int fd)
+{
+    const int flags = fcntl (fd, F_GETFL, 0);
+    fcntl (fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// ----------------
+// Wait (up to BACKEND_POLL_TIMEOUT_MS) until fd is ready for 'events'.
+// Returns true if ready.
+
+static
+bool backend_wait (const int fd, const short events)
+{
+    struct pollfd pfd;
+    pfd.fd      = fd;
+    pfd.events  = events;
+    pfd.revents = 0;
+    return (poll (& pfd, 1, BACKEND_POLL_TIMEOUT_MS) > 0);
+}
+
+// ----------------
+
+static
+void backend_open (UART_16550 *uart_p)
+{
+    uart_p->backend           = UART_BACKEND_STDIO;
+    uart_p->rx_fd             = fileno (stdin);
+    uart_p->tx_fd             = fileno (stdout);
+    uart_p->listen_fd         = -1;
+    uart_p->tx_fd_retired     = -1;
+    uart_p->tx_drop_when_full = false;
+
+    const char *spec = getenv ("UART_BACKEND");
+    if ((spec == NULL) || (strcmp (spec, "stdio") == 0))
+	return;
+
+    if (strcmp (spec, "pty") == 0) {
+	const int fd = posix_openpt (O_RDWR | O_NOCTTY);
+	if ((fd < 0) || (grantpt (fd) != 0) || (unlockpt (fd) != 0)) {
+	    fprintf (stdout, "ERROR: UART: unable to open pseudo-terminal\n");
+	    exit (1);
+	}
+	struct termios tio;
+	if (tcgetattr (fd, & tio) == 0) {
+	    cfmakeraw (& tio);
+	    tcsetattr (fd, TCSANOW, & tio);
+	}
+	set_nonblocking (fd);
+	fprintf (stdout, "UART: backend pty %s\n", ptsname (fd));
+	uart_p->backend           = UART_BACKEND_PTY;
+	uart_p->rx_fd             = fd;
+	uart_p->tx_fd             = fd;
+	uart_p->tx_drop_when_full = true;
+    }
+    else if (strncmp (spec, "unix:", 5) == 0) {
+	const char *path = spec + 5;
+	struct sockaddr_un addr;
+	memset (& addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen (path) >= sizeof (addr.sun_path)) {
+	    fprintf (stdout, "ERROR: UART: socket path too long: %s\n", path);
+	    exit (1);
+	}
+	strcpy (addr.sun_path, path);
+	unlink (path);
+
+	const int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+	if ((fd < 0)
+	    || (bind (fd, (struct sockaddr *) & addr, sizeof (addr)) != 0)
+	    || (listen (fd, 1) != 0)) {
+	    fprintf (stdout, "ERROR: UART: unable to listen on Unix socket %s\n", path);
+	    exit (1);
+	}
+	set_nonblocking (fd);
+	fprintf (stdout, "UART: backend Unix socket %s\n", path);
+	uart_p->backend           = UART_BACKEND_UNIX;
+	uart_p->listen_fd         = fd;
+	uart_p->rx_fd             = -1;    // until a client connects
+	uart_p->tx_fd             = -1;
+	uart_p->tx_drop_when_full = true;
+    }
+    else if (strncmp (spec, "file:", 5) == 0) {
+	char *capture = strdup (spec + 5);
+	char *replay  = strchr (capture, ',');
+	if (replay != NULL) {
+	    *replay = 0;
+	    replay++;
+	}
+	uart_p->backend = UART_BACKEND_FILE;
+	uart_p->tx_fd   = open (capture, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (uart_p->tx_fd < 0) {
+	    fprintf (stdout, "ERROR: UART: unable to open capture file %s\n", capture);
+	    exit (1);
+	}
+	uart_p->rx_fd = -1;
+	if (replay != NULL) {
+	    uart_p->rx_fd = open (replay, O_RDONLY | O_NONBLOCK);
+	    if (uart_p->rx_fd < 0) {
+		fprintf (stdout, "ERROR: UART: unable to open replay file %s\n", replay);
+		exit (1);
+	    }
+	}
+	fprintf (stdout, "UART: backend file: capture %s, replay %s\n",
+		 capture, ((replay != NULL) ? replay : "(none)"));
+	free (capture);
+    }
+    else {
+	fprintf (stdout, "ERROR: UART: unknown UART_BACKEND '%s'\n", spec);
+	fprintf (stdout, "    Expecting stdio, pty, unix:<path> or file:<capture>[,<replay>]\n");
+	exit (1);
+    }
+}
+
+// ----------------
+// Write out n chars from the TX thread.
+// Output is discarded if there is no destination (e.g., no client
+// connected to the Unix socket), or if the thread is asked to stop
+// while the destination is not accepting output.
+
+static bool tx_stop_requested (UART_16550 *uart_p);
+static void tx_wake_writer (UART_16550 *uart_p);
+
+static
+void backend_write (UART_16550 *uart_p, const uint8_t *p, uint64_t n)
+{
+    if (uart_p->backend == UART_BACKEND_STDIO) {
+	fwrite (p, 1, n, stdout);
+	fflush (stdout);
+	return;
+    }
+
+    while (n > 0) {
+	const int fd = __atomic_load_n (& (uart_p->tx_fd), __ATOMIC_ACQUIRE);
+	if (fd < 0)
+	    return;
+
+	const ssize_t k = ((uart_p->backend == UART_BACKEND_UNIX)
+			   ? send (fd, p, n, MSG_NOSIGNAL)
+			   : write (fd, p, n));
+	if (k > 0) {
+	    p += k;
+	    n -= k;
+	}
+	else if ((k < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+	    if ((! backend_wait (fd, POLLOUT)) && tx_stop_requested (uart_p))
+		return;
+	}
+	else if ((k < 0) && (errno == EINTR))
+	    continue;
+	else
+	    return;    // Peer gone, etc.: discard
+    }
+}
+
+// ----------------
+// Read up to n chars from the RX thread.  Waits (polling) for input,
+// and for a client on the Unix socket.
+// Returns number of chars read; 0 on EOF; < 0 if no further input.
+
+static
+ssize_t backend_read (UART_16550 *uart_p, uint8_t *buf, const size_t n)
+{
+    while (true) {
+	if (uart_p->backend == UART_BACKEND_UNIX) {
+	    if (uart_p->rx_fd < 0) {
+		if (! backend_wait (uart_p->listen_fd, POLLIN))
+		    continue;
+		const int fd = accept (uart_p->listen_fd, NULL, NULL);
+		if (fd < 0)
+		    continue;
+		set_nonblocking (fd);
+		uart_p->rx_fd = fd;
+		__atomic_store_n (& (uart_p->tx_fd), fd, __ATOMIC_RELEASE);
+	    }
+	}
+	else if (uart_p->rx_fd < 0)
+	    return -1;
+
+	const ssize_t k = read (uart_p->rx_fd, buf, n);
+	if (k > 0)
+	    return k;
+
+	if ((k < 0) && (errno == EINTR))
+	    continue;
+
+	if ((k < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+	    backend_wait (uart_p->rx_fd, POLLIN);
+	    continue;
+	}
+
+	// pty: EIO while no process has the slave side open
+	if ((k < 0) && (errno == EIO) && (uart_p->backend == UART_BACKEND_PTY)) {
+	    const struct timespec t = {0, BACKEND_POLL_TIMEOUT_MS * 1000000};
+	    nanosleep (& t, NULL);
+	    continue;
+	}
+
+	// Unix socket: client disconnected; wait for another one.
+	// The TX thread may be in backend_write() with this fd, so it is
+	// only shut down here (further sends fail, and are discarded),
+	// and handed to the TX thread to close (see tx_close_retired_fd());
+	// it cannot be reused for a new client before then.
+	if (uart_p->backend == UART_BACKEND_UNIX) {
+	    __atomic_store_n (& (uart_p->tx_fd), -1, __ATOMIC_RELEASE);
+	    shutdown (uart_p->rx_fd, SHUT_RDWR);
+	    while (__atomic_load_n (& (uart_p->tx_fd_retired), __ATOMIC_ACQUIRE) >= 0) {
+		// The previous one is not closed yet
+		tx_wake_writer (uart_p);
+		const struct timespec t = {0, BACKEND_POLL_TIMEOUT_MS * 1000000};
+		nanosleep (& t, NULL);
+	    }
+	    __atomic_store_n (& (uart_p->tx_fd_retired), uart_p->rx_fd, __ATOMIC_RELEASE);
+	    tx_wake_writer (uart_p);
+	    uart_p->rx_fd = -1;
+	    continue;
+	}
+
+	// EOF (k == 0) or error (k < 0)
+	return k;
+    }
+}
+
+// ****************************************************************
+// Transmit ring and writer thread
+
+#define TX_RING_SIZE_DEFAULT  0x10000
+#define TX_RING_SIZE_MIN      16
+
+// All UARTs, so that their TX rings can be drained at exit
+#define MAX_UARTS 8
+static UART_16550 *uarts [MAX_UARTS];
+static int         n_uarts = 0;
+
+static inline
+bool tx_ring_is_full (UART_16550 *uart_p)
+{
+    const uint64_t tail = __atomic_load_n (& (uart_p->tx_tail), __ATOMIC_ACQUIRE);
+    return ((uart_p->tx_head - tail) == uart_p->tx_ring_size);
+}
+
+static inline
+bool tx_ring_is_empty (UART_16550 *uart_p)
+{
+    const uint64_t tail = __atomic_load_n (& (uart_p->tx_tail), __ATOMIC_ACQUIRE);
+    return (uart_p->tx_head == tail);
+}
+
+static
+void tx_wake_writer (UART_16550 *uart_p)
+{
+    if (__atomic_load_n (& (uart_p->tx_writer_sleeping), __ATOMIC_SEQ_CST)) {
+	pthread_mutex_lock (& (uart_p->tx_mutex));
+	pthread_cond_signal (& (uart_p->tx_cond));
+	pthread_mutex_unlock (& (uart_p->tx_mutex));
+    }
+}
+
+// ----------------
+// Called on the simulation thread only.
+// Backpressure: if the ring is full (THRE is clear), wait for the
+// writer thread to make space (for pty/unix backends, drop the char).
+
+static
+void tx_ring_put (UART_16550 *uart_p, const uint8_t ch)
+{
+    const uint64_t head = uart_p->tx_head;
+    while (tx_ring_is_full (uart_p)) {
+	if (uart_p->tx_drop_when_full) {
+	    if (uart_p->tx_n_dropped == 0)
+		fprintf (stdout, "WARNING: UART: TX ring full; dropping output chars\n");
+	    uart_p->tx_n_dropped++;
+	    return;
+	}
+	tx_wake_writer (uart_p);
+	sched_yield ();
+    }
+    uart_p->tx_ring [head & (uart_p->tx_ring_size - 1)] = ch;
+    __atomic_store_n (& (uart_p->tx_head), head + 1, __ATOMIC_SEQ_CST);
+    tx_wake_writer (uart_p);
+}
+
+// ----------------
+// Wait until the writer thread has written out all chars in the ring
+
+static
+bool tx_stop_requested (UART_16550 *uart_p)
+{
+    return __atomic_load_n (& (uart_p->tx_stop), __ATOMIC_SEQ_CST);
+}
+
+static
+void tx_ring_drain (UART_16550 *uart_p)
+{
+    while (! tx_ring_is_empty (uart_p)) {
+	tx_wake_writer (uart_p);
+	sched_yield ();
+    }
+}
+
+void UART_16550_flush (UART_16550 *uart_p)
+{
+    tx_ring_drain (uart_p);
+}
+
+// ----------------
+// Close a Unix-socket client fd shut down by the RX thread (see
+// backend_read()).  Only the TX thread uses tx_fd, so once it is
+// here, it holds no copy of the old fd.
+
+static
+void tx_close_retired_fd (UART_16550 *uart_p)
+{
+    const int fd = __atomic_load_n (& (uart_p->tx_fd_retired), __ATOMIC_ACQUIRE);
+    if (fd >= 0) {
+	close (fd);
+	__atomic_store_n (& (uart_p->tx_fd_retired), -1, __ATOMIC_RELEASE);
+    }
+}
+
+// ----------------
+
+static
+void *tx_writer_thread (void *arg)
+{
+    UART_16550 *uart_p = (UART_16550 *) arg;
+    const uint64_t mask = uart_p->tx_ring_size - 1;
+
+    while (true) {
+	tx_close_retired_fd (uart_p);
+
+	const uint64_t tail = uart_p->tx_tail;
+	const uint64_t head = __atomic_load_n (& (uart_p->tx_head), __ATOMIC_SEQ_CST);
+
+	if (head == tail) {
+	    if (__atomic_load_n (& (uart_p->tx_stop), __ATOMIC_SEQ_CST))
+		break;
+
+	    // Sleep until woken by the producer (the timeout is only a safety net)
+	    pthread_mutex_lock (& (uart_p->tx_mutex));
+	    __atomic_store_n (& (uart_p->tx_writer_sleeping), true, __ATOMIC_SEQ_CST);
+	    if ((__atomic_load_n (& (uart_p->tx_head), __ATOMIC_SEQ_CST) == tail)
+		&& (! __atomic_load_n (& (uart_p->tx_stop), __ATOMIC_SEQ_CST))) {
+		struct timespec deadline;
+		clock_gettime (CLOCK_REALTIME, & deadline);
+		deadline.tv_nsec += 100000000;
+		if (deadline.tv_nsec >= 1000000000) {
+		    deadline.tv_sec++;
+		    deadline.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait (& (uart_p->tx_cond), & (uart_p->tx_mutex), & deadline);
+	    }
+	    __atomic_store_n (& (uart_p->tx_writer_sleeping), false, __ATOMIC_SEQ_CST);
+	    pthread_mutex_unlock (& (uart_p->tx_mutex));
+	    continue;
+	}
+
+	// Write out the contiguous chunk starting at tail
+	const uint64_t j = tail & mask;
+	uint64_t       n = head - tail;
+	if (n > (uart_p->tx_ring_size - j))
+	    n = uart_p->tx_ring_size - j;
+	backend_write (uart_p, & (uart_p->tx_ring [j]), n);
+
+	__atomic_store_n (& (uart_p->tx_tail), tail + n, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+// ----------------
+// At exit: write out all pending output, and stop the writer threads
+
+static
+void tx_writers_stop_at_exit (void)
+{
+    for (int j = 0; j < n_uarts; j++) {
+	UART_16550 *uart_p = uarts [j];
+	__atomic_store_n (& (uart_p->tx_stop), true, __ATOMIC_SEQ_CST);
+	pthread_mutex_lock (& (uart_p->tx_mutex));
+	pthread_cond_signal (& (uart_p->tx_cond));
+	pthread_mutex_unlock (& (uart_p->tx_mutex));
+	pthread_join (uart_p->tx_thread, NULL);
+    }
+    n_uarts = 0;
+}
+
+// ----------------
+// Ring capacity from env variable UART_TX_RING_SIZE (bytes; rounded
+// up to a power of 2)
+
+static
+void tx_ring_init (UART_16550 *uart_p)
+{
+    uint64_t size_B = TX_RING_SIZE_DEFAULT;
+    const char *s = getenv ("UART_TX_RING_SIZE");
+    if (s != NULL) {
+	size_B = strtoull (s, NULL, 0);
+	if (size_B < TX_RING_SIZE_MIN)
+	    size_B = TX_RING_SIZE_MIN;
+    }
+    uint64_t size_pow2 = 1;
+    while (size_pow2 < size_B)
+	size_pow2 = size_pow2 << 1;
+
+    uart_p->tx_ring      = (uint8_t *) malloc (size_pow2);
+    uart_p->tx_ring_size = size_pow2;
+    if (uart_p->tx_ring == NULL) {
+	fprintf (stdout, "INTERNAL ERROR: %s(): malloc failed for TX ring (%0" PRId64 " bytes)\n",
+		 __FUNCTION__, size_pow2);
+	exit (1);
+    }
+    if (n_uarts == MAX_UARTS) {
+	fprintf (stdout, "INTERNAL ERROR: %s(): too many UARTs (max %0d)\n",
+		 __FUNCTION__, MAX_UARTS);
+	exit (1);
+    }
+
+    pthread_mutex_init (& (uart_p->tx_mutex), NULL);
+    pthread_cond_init  (& (uart_p->tx_cond),  NULL);
+    if (pthread_create (& (uart_p->tx_thread), NULL, tx_writer_thread, uart_p) != 0) {
+	fprintf (stdout, "INTERNAL ERROR: %s(): unable to create TX writer thread\n",
+		 __FUNCTION__);
+	exit (1);
+    }
+
+    if (n_uarts == 0)
+	atexit (tx_writers_stop_at_exit);
+    uarts [n_uarts] = uart_p;
+    n_uarts++;
+}
+
+// ****************************************************************
+// RX FIFO and reader thread
+
+#define RX_FIFO_SIZE_DEFAULT  16
+
+static inline
+uint64_t rx_fifo_count (UART_16550 *uart_p)
+{
+    const uint64_t head = __atomic_load_n (& (uart_p->rx_head), __ATOMIC_ACQUIRE);
+    return ((head - uart_p->rx_tail)
+	    + (uart_p->rx_restored_n - uart_p->rx_restored_next));
+}
+
+bool UART_16550_rx_pending (UART_16550 *uart_p)
+{
+    return (rx_fifo_count (uart_p) != 0);
+}
+
+// ----------------
+// Called on the simulation thread only; FIFO must be non-empty
+
+static inline
+uint8_t rx_fifo_pop (UART_16550 *uart_p)
+{
+    if (__builtin_expect (uart_p->rx_restored_next < uart_p->rx_restored_n, 0))
+	return uart_p->rx_restored [uart_p->rx_restored_next++];
+
+    const uint64_t tail = uart_p->rx_tail;
+    const uint8_t  ch   = uart_p->rx_fifo [tail & (uart_p->rx_fifo_size - 1)];
+    __atomic_store_n (& (uart_p->rx_tail), tail + 1, __ATOMIC_RELEASE);
+    return ch;
+}
+
+// ----------------
+// Called on the RX thread only.
+// If the FIFO is full, wait for the CPU to read chars (a real 16550
+// would overrun and lose chars).
+
+static
+void rx_fifo_push (UART_16550 *uart_p, const uint8_t ch)
+{
+    const uint64_t head = uart_p->rx_head;
+    while ((head - __atomic_load_n (& (uart_p->rx_tail), __ATOMIC_ACQUIRE))
+	   == uart_p->rx_fifo_size) {
+	const struct timespec t = {0, 1000000};    // 1 ms
+	nanosleep (& t, NULL);
+    }
+    uart_p->rx_fifo [head & (uart_p->rx_fifo_size - 1)] = ch;
+    __atomic_store_n (& (uart_p->rx_head), head + 1, __ATOMIC_RELEASE);
+}
+
+// ----------------
+
+static
+void *rx_reader_thread (void *arg)
+{
+    UART_16550 *uart_p = (UART_16550 *) arg;
+    uint8_t     buf [256];
+
+    while (true) {
+	const ssize_t n = backend_read (uart_p, buf, sizeof (buf));
+	if (n < 0) {
+	    fprintf (stdout, "ERROR: UART: read failed; no further UART input\n");
+	    break;
+	}
+	if (n == 0) {
+	    // EOF, e.g., stdin redirected from /dev/null, or end of replay file
+	    fprintf (stdout, "EOF on UART input; no further UART input\n");
+	    break;
+	}
+	for (ssize_t j = 0; j < n; j++)
+	    rx_fifo_push (uart_p, buf [j]);
+    }
+    return NULL;
+}
+
+// ----------------
+// FIFO capacity from env variable UART_RX_FIFO_SIZE (bytes; rounded
+// up to a power of 2).  The RX thread reads from the backend.
+
+static
+void rx_fifo_init (UART_16550 *uart_p)
+{
+    uint64_t size_B = RX_FIFO_SIZE_DEFAULT;
+    const char *s = getenv ("UART_RX_FIFO_SIZE");
+    if (s != NULL) {
+	size_B = strtoull (s, NULL, 0);
+	if (size_B < 1)
+	    size_B = 1;
+    }
+    uint64_t size_pow2 = 1;
+    while (size_pow2 < size_B)
+	size_pow2 = size_pow2 << 1;
+
+    uart_p->rx_fifo      = (uint8_t *) malloc (size_pow2);
+    uart_p->rx_fifo_size = size_pow2;
+    if (uart_p->rx_fifo == NULL) {
+	fprintf (stdout, "INTERNAL ERROR: %s(): malloc failed for RX FIFO (%0" PRId64 " bytes)\n",
+		 __FUNCTION__, size_pow2);
+	exit (1);
+    }
+
+    // No input at all (e.g., file backend without replay file)
+    if ((uart_p->rx_fd < 0) && (uart_p->backend != UART_BACKEND_UNIX))
+	return;
+
+    // The thread may be blocked in read() at exit, so it is not joined
+    if (pthread_create (& (uart_p->rx_thread), NULL, rx_reader_thread, uart_p) != 0) {
+	fprintf (stdout, "INTERNAL ERROR: %s(): unable to create RX reader thread\n",
+		 __FUNCTION__);
+	exit (1);
+    }
+    pthread_detach (uart_p->rx_thread);
+}
+
+// ****************************************************************
+// 16550 FIFO semantics, on top of the RX FIFO and TX ring.
+// With FIFOs enabled (FCR[0]) the CPU sees 16-byte FIFOs: THRE means
+// the CPU may write UART_FIFO_DEPTH chars, and RX interrupts are
+// raised at the FCR trigger level, or on character timeout.
+
+static inline
+bool fifo_mode (const UART_16550 *uart_p)
+{
+    return ((uart_p->rg_fcr & uart_fcr_fifo_enable) != 0);
+}
+
+static inline
+uint64_t rx_trigger_level (const UART_16550 *uart_p)
+{
+    if (! fifo_mode (uart_p))
+	return 1;
+
+    switch ((uart_p->rg_fcr & uart_fcr_rx_trigger) >> 6) {
+    case 0:  return 1;
+    case 1:  return 4;
+    case 2:  return 8;
+    default: return 14;
+    }
+}
+
+// ----------------
+// TX holding register (or, with FIFOs enabled, the TX FIFO) is empty
+
+static inline
+bool tx_holding_empty (UART_16550 *uart_p)
+{
+    const uint64_t tail   = __atomic_load_n (& (uart_p->tx_tail), __ATOMIC_ACQUIRE);
+    const uint64_t n_free = uart_p->tx_ring_size - (uart_p->tx_head - tail);
+    return (n_free >= (fifo_mode (uart_p) ? UART_FIFO_DEPTH : 1));
+}
+
+// ----------------
+// Note RX activity (new chars from the RX thread); one atomic load
+
+static inline
+void rx_note_activity (UART_16550 *uart_p)
+{
+    const uint64_t head = __atomic_load_n (& (uart_p->rx_head), __ATOMIC_ACQUIRE);
+    if (head != uart_p->rx_seen_head) {
+	uart_p->rx_seen_head     = head;
+	uart_p->rx_activity_tick = uart_p->cur_tick;
+    }
+}
+
+// ****************************************************************
+// LSR, with DR reflecting the state of the RX FIFO and THRE/TEMT
+// reflecting the state of the TX ring
+
+static inline
+uint8_t fn_lsr (UART_16550 *uart_p)
+{
+    uint8_t lsr = (uart_p->rg_lsr & (~ (uart_lsr_dr | uart_lsr_thre | uart_lsr_temt)));
+    if (rx_fifo_count (uart_p) != 0)
+	lsr |= uart_lsr_dr;
+    if (tx_holding_empty (uart_p))
+	lsr |= uart_lsr_thre;
+    if (tx_ring_is_empty (uart_p))
+	lsr |= uart_lsr_temt;
+    return lsr;
+}
+
 // ----------------
 // Virtual read-only register IIR (interrupt identification register)
+// RDA (at the FCR trigger level), CTI and THRE set the UART's
+// interrupt level (UART_16550_irq_level()), which C_Mems_Devices.c
+// drives onto MEIP.  The CPU has no MEIP input (only MTIP), so the
+// hart never takes these interrupts; software sees them only by
+// reading IIR or LSR.
 
 inline
 static
@@ -134,15 +841,33 @@ uint8_t fn_iir (UART_16550 *uart_p)
 {
     uint8_t iir = uart_iir_none;
 
+    rx_note_activity (uart_p);
+    const uint64_t rx_count = rx_fifo_count (uart_p);
+
+    // Raise THRE interrupt when TX becomes empty after THR writes
+    if (uart_p->tx_armed && tx_holding_empty (uart_p)) {
+	uart_p->thre_ip  = true;
+	uart_p->tx_armed = false;
+    }
+
     if (((uart_p->rg_ier & uart_ier_erbfi) != 0)    // Rx interrupt enabled
-	&& ((uart_p->rg_lsr & uart_lsr_dr) != 0))   // data ready
+	&& (rx_count >= rx_trigger_level (uart_p)))   // data ready
 	iir = uart_iir_rda;
 
-    else if ((uart_p->rg_ier & uart_ier_etbei) != 0) {
-	// Tx Holding Reg Empty intr enabled
+    else if (((uart_p->rg_ier & uart_ier_erbfi) != 0)
+	     && fifo_mode (uart_p)
+	     && (rx_count != 0)
+	     && ((uart_p->cur_tick - uart_p->rx_activity_tick) >= (4 * UART_CHAR_TIME_TICKS)))
+	iir = uart_iir_cti;
+
+    else if (((uart_p->rg_ier & uart_ier_etbei) != 0)    // Tx Holding Reg Empty intr enabled
+	     && uart_p->thre_ip) {
 	iir = uart_iir_thre;
     }
 
+    if (fifo_mode (uart_p))
+	iir |= uart_iir_fifos;
+
     return iir;
 }
 
@@ -169,6 +894,10 @@ UART_16550 *mkUART_16550 (const uint64_t addr_base, const uint8_t addr_stride)
     uart_p->addr_base   = addr_base;
     uart_p->addr_stride = addr_stride;
 
+    backend_open (uart_p);
+    tx_ring_init (uart_p);
+    rx_fifo_init (uart_p);
+
     UART_16550_assert_reset (uart_p);
     UART_16550_deassert_reset (uart_p);
 
@@ -191,6 +920,11 @@ bool irq_UART (UART_16550 *uart_p)
     return result;
 }
 
+bool UART_16550_irq_level (UART_16550 *uart_p)
+{
+    return ((fn_iir (uart_p) & uart_iir_none) == 0);
+}
+
 // ****************************************************************
 // External API to assert reset, deassert reset
 
@@ -209,13 +943,10 @@ void UART_16550_assert_reset (UART_16550 *uart_p)
     uart_p->rg_msr = 0;
     uart_p->rg_scr = 0;
 
-    uart_p->in_linebuf_len  = 0;
-    uart_p->in_linebuf_next = 0;
-
-    uart_p->out_linebuf_next        = 0;
-    uart_p->out_linebuf_update_tick = 0;
-
     uart_p->last_irq = false;
+
+    uart_p->thre_ip  = false;
+    uart_p->tx_armed = false;
 }
 
 void UART_16550_deassert_reset (UART_16550 *uart_p)
@@ -227,100 +958,18 @@ void UART_16550_deassert_reset (UART_16550 *uart_p)
 }
 
 // ****************************************************************
-// 'tick' should be called regularly by the system, so that the UART
-// can run "concurrently" with the system.  In tick(), can:
-// * flush output buffer to screen if needed
-// * read keyboard input is available for the input buffer
-// * raise tx/rx interrupts if needed
-
-// ----------------
-// Test if input from keyboard is available
-
-inline
-static
-bool input_is_available (const int fd)
+// 'tick' lets the UART run "concurrently" with the system.
+// Output chars are written out by the TX writer thread, and input
+// chars are deposited by the RX reader thread; tick() only keeps
+// time for the RX character-timeout interrupt.  For that, noticing
+// RX activity to within a fraction of a character time is enough, so
+// tick() asks to be called again only after that long.
+
+uint64_t UART_16550_tick (UART_16550 *uart_p, const uint64_t tick_num)
 {
-    struct pollfd  x_pollfd;
-
-    x_pollfd.fd      = fd;
-    x_pollfd.events  = POLLRDNORM;
-    x_pollfd.revents = 0;
-    poll (& x_pollfd, 1, 0);
-
-    return ((x_pollfd.revents & POLLRDNORM) != 0);
-}
-
-// This is a forward declaration
-int UART_16550_receive_from_serial_line (UART_16550 *uart_p, const uint8_t ch);
-
-static uint64_t global_tick_num = 0;
-
-void UART_16550_tick (UART_16550 *uart_p, const uint64_t tick_num)
-{
-    global_tick_num++;
-
-    // Output chars: flush out_linebuf if chars pending for some time
-    const int AGE_FLUSH_THRESHOLD = 100;
-    if ((uart_p->out_linebuf_next != 0)
-	&& ((global_tick_num - uart_p->out_linebuf_update_tick) > AGE_FLUSH_THRESHOLD)) {
-	uart_p->out_linebuf [uart_p->out_linebuf_next] = 0;
-	fprintf (stdout, "%s", uart_p->out_linebuf);
-	fflush (stdout);
-
-	uart_p->out_linebuf_next = 0;
-	uart_p->out_linebuf_update_tick = global_tick_num;
-    }
-
-    // ----------------
-    // Input chars (keyboard -> UART)
-
-    if ((global_tick_num & UART_INPUT_POLL_FREQUENCY_MASK) == 0) {
-
-	// If in_linebuf is empty; try refill it from keyboard
-	if (uart_p->in_linebuf_next >= uart_p->in_linebuf_len) {
-	    const int fd_stdin = fileno (stdin);
-	    if (input_is_available (fd_stdin)) {
-		const char *p = fgets (& (uart_p->in_linebuf [0]), IN_LINEBUF_SIZE, stdin);
-		if (p == NULL) {
-		    fprintf (stdout, "EOF on stdin; quitting\n");
-		    exit (1);
-		}
-		uart_p->in_linebuf_len  = strlen (p);
-		uart_p->in_linebuf_next = 0;
-	    }
-	}
-
-	// If in_linebuf is non-empty, try to feed UART
-	if (uart_p->in_linebuf_next < uart_p->in_linebuf_len) {
-	    const uint8_t ch = uart_p->in_linebuf [uart_p->in_linebuf_next];
-	    int rc = UART_16550_receive_from_serial_line (uart_p, ch);
-	    if (rc == RC_OK)
-		uart_p->in_linebuf_next++;
-	}
-    }
-}
-
-// ****************************************************************
-// External API for serial line to deposit a char into the UART
-// Return RC_OK if successfull, RC_ERR otherwise (RBR is not empty)
-
-int UART_16550_receive_from_serial_line (UART_16550 *uart_p, const uint8_t ch)
-{
-    const bool rbr_is_empty = ((uart_p->rg_lsr & uart_lsr_dr) == 0);
-    if (rbr_is_empty) {
-	uart_p->rg_rbr  = ch;
-	uint8_t new_lsr = (uart_p->rg_lsr | uart_lsr_dr);    // set data-ready
-	uart_p->rg_lsr  = new_lsr;
-	return RC_OK;
-    }
-    else {
-	fprintf (stdout, "WARNING: UART: %s: rg_rbr is not empty; ch is:", __FUNCTION__);
-	if (ch <= ' ')
-	    fprintf (stdout, " 0x%0x\n", ch);
-	else
-	    fprintf (stdout, " '%c'\n", ch);
-	return RC_ERR;
-    }
+    uart_p->cur_tick = tick_num;
+    rx_note_activity (uart_p);
+    return tick_num + (UART_CHAR_TIME_TICKS / 4);
 }
 
 // ****************************************************************
@@ -435,8 +1084,13 @@ int UART_16550_try_mem_access (UART_16550     *uart_p,
 		fprintf (stdout,
 			 "    UART reg RBR (0 when lcr_dlab == 0)\n");
 
-	    uart_p->rg_lsr = (uart_p->rg_lsr & (~ uart_lsr_dr));    // Reset data-ready
+	    // Pop the next input char, if any (data-ready follows the FIFO)
+	    if (rx_fifo_count (uart_p) != 0)
+		uart_p->rg_rbr = rx_fifo_pop (uart_p);
 	    rdata = uart_p->rg_rbr;
+
+	    // Reading RBR restarts the character timeout
+	    uart_p->rx_activity_tick = uart_p->cur_tick;
 	}
 	else if ((uart_reg_num == addr_UART_dll)
 		 && ((uart_p->rg_lcr & uart_lcr_dlab) != 0)) {
@@ -464,6 +1118,10 @@ int UART_16550_try_mem_access (UART_16550     *uart_p,
 	    if (verbosity != 0)
 		fprintf (stdout, "    UART reg IIR (2)\n");
 	    rdata = fn_iir (uart_p);
+
+	    // Reading IIR clears a THRE interrupt that it reports
+	    if ((rdata & 0x0F) == uart_iir_thre)
+		uart_p->thre_ip = false;
 	}
 	else if (uart_reg_num == addr_UART_lcr) {
 	    if (verbosity != 0)
@@ -478,7 +1136,7 @@ int UART_16550_try_mem_access (UART_16550     *uart_p,
 	else if (uart_reg_num == addr_UART_lsr) {     // line status reg
 	    if (verbosity != 0)
 		fprintf (stdout, "    UART reg LSR (5)\n");
-	    rdata = uart_p->rg_lsr;
+	    rdata = fn_lsr (uart_p);
 	}
 	else if (uart_reg_num == addr_UART_msr) {
 	    if (verbosity != 0)
@@ -522,17 +1180,10 @@ int UART_16550_try_mem_access (UART_16550     *uart_p,
 		fprintf (stdout, "\n");
 	    }
 
-	    // Write the char to the output line buffer
-	    uart_p->out_linebuf [uart_p->out_linebuf_next] = wdata;
-	    uart_p->out_linebuf_next++;
-	    uart_p->out_linebuf_update_tick = global_tick_num;
-	    if ((wdata == '\n')
-		|| ((uart_p->out_linebuf_next + 1) == OUT_LINEBUF_SIZE)) {
-		uart_p->out_linebuf [uart_p->out_linebuf_next] = 0;
-		fprintf (stdout, "%s", uart_p->out_linebuf);
-		fflush (stdout);
-		uart_p->out_linebuf_next = 0;
-	    }
+	    // Send the char to the TX ring (written out by the writer thread)
+	    tx_ring_put (uart_p, wdata);
+	    uart_p->thre_ip  = false;
+	    uart_p->tx_armed = true;
 	}
 	else if ((uart_reg_num == addr_UART_dll)
 		 && ((uart_p->rg_lcr & uart_lcr_dlab) != 0)) {
@@ -546,6 +1197,13 @@ int UART_16550_try_mem_access (UART_16550     *uart_p,
 	    if (verbosity != 0)
 		fprintf (stdout,
 			 "    UART reg IER (1 when lcr_dlab == 0)\n");
+
+	    // Enabling the THRE interrupt while THR is empty raises it
+	    if (((uart_p->rg_ier & uart_ier_etbei) == 0)
+		&& ((wdata & uart_ier_etbei) != 0)
+		&& tx_holding_empty (uart_p))
+		uart_p->thre_ip = true;
+
 	    uart_p->rg_ier = wdata;
 	}
 	else if ((uart_reg_num == addr_UART_dlm)
@@ -558,7 +1216,19 @@ int UART_16550_try_mem_access (UART_16550     *uart_p,
 	else if (uart_reg_num == addr_UART_fcr) {
 	    if (verbosity != 0)
 		fprintf (stdout, "    UART reg FCR (2)\n");
-	    uart_p->rg_fcr = wdata;
+
+	    // Clear RX FIFO: discard all chars received so far
+	    if ((wdata & uart_fcr_rx_reset) != 0) {
+		__atomic_store_n (& (uart_p->rx_tail),
+				  __atomic_load_n (& (uart_p->rx_head), __ATOMIC_ACQUIRE),
+				  __ATOMIC_RELEASE);
+		uart_p->rx_restored_next = uart_p->rx_restored_n;
+	    }
+
+	    // (Clear TX FIFO is a no-op: chars in the TX ring are
+	    // already on their way to the screen)
+
+	    uart_p->rg_fcr = (wdata & (~ (uart_fcr_rx_reset | uart_fcr_tx_reset)));
 	}
 	else if (uart_reg_num == addr_UART_lcr) {
 	    if (verbosity != 0)
@@ -595,3 +1265,111 @@ int UART_16550_try_mem_access (UART_16550     *uart_p,
 }
 
 // ****************************************************************
+// Checkpointing
+
+// Saved state: registers, unread input chars (from the RX FIFO, up to
+// UART_CKPT_RX_MAX), and the time since the last RX activity, for the
+// character timeout.
+// (Pending screen output in the TX ring is drained when saving.)
+// On restore, the saved input chars are read by the CPU before any
+// new input.
+
+typedef struct {
+    uint8_t  rg_rbr;
+    uint8_t  rg_thr;
+    uint8_t  rg_dll;
+    uint8_t  rg_ier;
+    uint8_t  rg_dlm;
+    uint8_t  rg_fcr;
+    uint8_t  rg_lcr;
+    uint8_t  rg_mcr;
+    uint8_t  rg_lsr;
+    uint8_t  rg_msr;
+    uint8_t  rg_scr;
+    uint8_t  last_irq;
+    uint8_t  thre_ip;
+    uint8_t  tx_armed;
+    uint16_t rx_n;                         // number of chars in rx_chars
+    uint64_t rx_idle_ticks;                // ticks since last RX activity
+    uint8_t  rx_chars [UART_CKPT_RX_MAX];
+} UART_16550_Checkpoint;
+
+size_t UART_16550_checkpoint_size (void)
+{
+    return sizeof (UART_16550_Checkpoint);
+}
+
+void UART_16550_checkpoint_save (UART_16550 *uart_p, uint8_t *buf)
+{
+    tx_ring_drain (uart_p);
+
+    UART_16550_Checkpoint ckpt;
+    memset (& ckpt, 0, sizeof (ckpt));
+    ckpt.rg_rbr   = uart_p->rg_rbr;
+    ckpt.rg_thr   = uart_p->rg_thr;
+    ckpt.rg_dll   = uart_p->rg_dll;
+    ckpt.rg_ier   = uart_p->rg_ier;
+    ckpt.rg_dlm   = uart_p->rg_dlm;
+    ckpt.rg_fcr   = uart_p->rg_fcr;
+    ckpt.rg_lcr   = uart_p->rg_lcr;
+    ckpt.rg_mcr   = uart_p->rg_mcr;
+    ckpt.rg_lsr   = uart_p->rg_lsr;
+    ckpt.rg_msr   = uart_p->rg_msr;
+    ckpt.rg_scr   = uart_p->rg_scr;
+    ckpt.last_irq = uart_p->last_irq;
+    ckpt.thre_ip  = uart_p->thre_ip;
+    ckpt.tx_armed = uart_p->tx_armed;
+
+    // Unread input, oldest first: restored chars not yet read, then
+    // the RX FIFO (read without popping; the RX thread only appends)
+    rx_note_activity (uart_p);
+    const uint64_t head = __atomic_load_n (& (uart_p->rx_head), __ATOMIC_ACQUIRE);
+    uint32_t n = 0;
+    for (uint32_t j = uart_p->rx_restored_next;
+	 (j < uart_p->rx_restored_n) && (n < UART_CKPT_RX_MAX);
+	 j++)
+	ckpt.rx_chars [n++] = uart_p->rx_restored [j];
+    for (uint64_t t = uart_p->rx_tail; (t != head) && (n < UART_CKPT_RX_MAX); t++)
+	ckpt.rx_chars [n++] = uart_p->rx_fifo [t & (uart_p->rx_fifo_size - 1)];
+    if (rx_fifo_count (uart_p) > n)
+	fprintf (stdout, "WARNING: UART checkpoint: %0" PRId64 " unread input chars;"
+		 " saving only the first %0d\n",
+		 rx_fifo_count (uart_p), UART_CKPT_RX_MAX);
+    ckpt.rx_n          = n;
+    ckpt.rx_idle_ticks = uart_p->cur_tick - uart_p->rx_activity_tick;
+
+    memcpy (buf, & ckpt, sizeof (ckpt));
+}
+
+void UART_16550_checkpoint_restore (UART_16550 *uart_p, const uint8_t *buf)
+{
+    UART_16550_Checkpoint ckpt;
+    memcpy (& ckpt, buf, sizeof (ckpt));
+
+    uart_p->rg_rbr   = ckpt.rg_rbr;
+    uart_p->rg_thr   = ckpt.rg_thr;
+    uart_p->rg_dll   = ckpt.rg_dll;
+    uart_p->rg_ier   = ckpt.rg_ier;
+    uart_p->rg_dlm   = ckpt.rg_dlm;
+    uart_p->rg_fcr   = ckpt.rg_fcr;
+    uart_p->rg_lcr   = ckpt.rg_lcr;
+    uart_p->rg_mcr   = ckpt.rg_mcr;
+    uart_p->rg_lsr   = ckpt.rg_lsr;
+    uart_p->rg_msr   = ckpt.rg_msr;
+    uart_p->rg_scr   = ckpt.rg_scr;
+    uart_p->last_irq = ckpt.last_irq;
+    uart_p->thre_ip  = ckpt.thre_ip;
+    uart_p->tx_armed = ckpt.tx_armed;
+
+    const uint32_t n = ((ckpt.rx_n <= UART_CKPT_RX_MAX) ? ckpt.rx_n : UART_CKPT_RX_MAX);
+    memcpy (uart_p->rx_restored, ckpt.rx_chars, n);
+    uart_p->rx_restored_n    = n;
+    uart_p->rx_restored_next = 0;
+
+    // Input that arrived before the restore counts as activity now;
+    // otherwise the character timeout continues from the saved point
+    uart_p->rx_seen_head     = __atomic_load_n (& (uart_p->rx_head), __ATOMIC_ACQUIRE);
+    uart_p->rx_activity_tick = uart_p->cur_tick - ckpt.rx_idle_ticks;
+}
+
+// ****************************************************************
@@ -17,10 +17,16 @@ UART_16550 *mkUART_16550 (const uint64_t addr_base, const uint8_t addr_stride);
 
 // ****************************************************************
 // UART interrupts
+// irq_UART() is true on a 0->1 transition of the interrupt request;
+// UART_16550_irq_level() is its current level (some interrupt enabled
+// in IER is pending, as reported by IIR).
 
 extern
 bool irq_UART (UART_16550 *uart_p);
 
+extern
+bool UART_16550_irq_level (UART_16550 *uart_p);
+
 // ****************************************************************
 // External API to assert reset, deassert reset
 
@@ -31,13 +37,32 @@ extern
 void UART_16550_deassert_reset (UART_16550 *uart_p);
 
 // ****************************************************************
-// 'tick' should be called regularly by the system, so that the UART
-// can run "concurrently" with the system.  In tick(), can:
-// * flush output buffer to screen if needed
-// * read keyboard input is available for the input buffer
-// * raise tx/rx interrupts if needed
+// 'tick' lets the UART run "concurrently" with the system.
+// (Screen output and keyboard input are handled by background TX/RX
+// threads, so tick() has little to do.)
+// Returns the tick at which tick() should next be called; it should
+// also be called before each MMIO access, so the UART knows the time.
+
+uint64_t UART_16550_tick (UART_16550 *uart_p, const uint64_t tick_num);
+
+// ****************************************************************
+// Output chars are written out by a background writer thread, from a
+// TX ring of UART_TX_RING_SIZE bytes (env variable; default 64 KiB).
+// The "serial line" (stdio, pty, Unix socket or files) is selected by
+// env variable UART_BACKEND when the UART is created (see UART_model.c).
+// Input chars are read by a background reader thread (from the backend) into
+// an RX FIFO of UART_RX_FIFO_SIZE bytes (env variable; default 16).
+// flush() waits until all chars written so far have been written out.
+
+extern
+void UART_16550_flush (UART_16550 *uart_p);
+
+// ----------------
+// Returns true if input chars are waiting in the RX FIFO (used to
+// decide whether the system is really idle).
 
-void UART_16550_tick (UART_16550 *uart_p, const uint64_t tick_num);
+extern
+bool UART_16550_rx_pending (UART_16550 *uart_p);
 
 // ****************************************************************
 // The main MMIO function.
@@ -51,6 +76,20 @@ int UART_16550_try_mem_access (UART_16550     *uart_p,
 			       const uint8_t   size_B,
 			       const uint8_t   wdata);
 
+// ****************************************************************
+// Checkpointing (see C_Mems_Devices.c).
+// The UART's state, including unread input chars in the RX FIFO, is
+// saved to/restored from an opaque buffer of
+// UART_16550_checkpoint_size() bytes.
+
+extern
+size_t UART_16550_checkpoint_size (void);
+
+extern
+void UART_16550_checkpoint_save (UART_16550 *uart_p, uint8_t *buf);
+
+extern
+void UART_16550_checkpoint_restore (UART_16550 *uart_p, const uint8_t *buf);
 
 
 // ****************************************************************
@@ -50,15 +50,35 @@ BSCFLAGS = -D $(RV) \
 
 C_FILES  = $(SRC_TOP)/C_Mems_Devices.c
 C_FILES += $(SRC_TOP)/UART_model.c
+C_FILES += $(SRC_TOP)/CLINT_model.c
+C_FILES += $(SRC_TOP)/Elf_Loader.c
+C_FILES += $(SRC_TOP)/Memhex_Loader.c
+C_FILES += $(SRC_TOP)/Device_Registry.c
+C_FILES += $(SRC_TOP)/BTrace.c
+C_FILES += $(SRC_TOP)/PC_Profile.c
 C_FILES += $(REPO)/TestRIG/vendor/SocketPacketUtils/socket_packet_utils.c
 
 # Only needed if we import C code
 BSC_C_FLAGS += -Xl -v  -Xc -O3  -Xc++ -O3
 
+# For the parallel memhex32 loader (and other C threads)
+BSC_C_FLAGS += -Xl -lpthread
+
 ifdef DRUM_RULES
 BSCFLAGS += -D DRUM_RULES
 endif
 
+# When the hart idles in a tight loop waiting for the timer, jump MTIME
+# to MTIMECMP (changes observed timing; off by default)
+ifdef IDLE_SKIP
+BSCFLAGS += -D IDLE_SKIP
+endif
+
+# zstd-compress the binary trace (+btrace) blocks (needs libzstd)
+ifdef BTRACE_ZSTD
+BSC_C_FLAGS += -Xc -DBTRACE_ZSTD  -Xc++ -DBTRACE_ZSTD  -Xl -lzstd
+endif
+
 # ----------------
 # bsc's directory search path
 
@@ -144,6 +164,6 @@ clean:
 
 .PHONY: full_clean
 full_clean: clean
-	rm -r -f  exe_*  verilog  log*  $(SRC_TOP)/*.o  $(SRC_TOP_TESTRIG)/*.o  obj_dir_*
+	rm -r -f  exe_*  verilog  log*  trace.btr*  $(SRC_TOP)/*.o  $(SRC_TOP_TESTRIG)/*.o  obj_dir_*
 
 # ****************************************************************
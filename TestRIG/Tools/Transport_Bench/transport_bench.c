@@ -0,0 +1,275 @@
+// Copyright (c) 2026 Rishiyur S. Nikhil.  All Rights Reserved.
+
+// ****************************************************************
+// Throughput of the RVFI-DII transports of socket_packet_utils: TCP
+// vs. shared memory (see README.txt).
+
+// A child process stands in for the simulator: it makes the same calls
+// as vendor/BSV-RVFI-DII/Socket.bsv (8 x serv_socket_get8() per DII
+// instruction, 88 x serv_socket_put8_blocking() per RVFI trace).  The
+// parent stands in for the test generator: it keeps up to --batch
+// instructions in flight and reads back one trace per instruction.
+
+// ****************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "../../vendor/SocketPacketUtils/socket_packet_utils.h"
+#include "../../vendor/SocketPacketUtils/shm_client.h"
+
+// ****************************************************************
+
+#define DII_BYTES   8
+#define RVFI_BYTES  88
+
+#define SOCKET_NAME  "Transport_Bench"
+#define SHM_NAME     "/transport_bench"
+
+static uint64_t  n_instrs  = 1000000;
+static uint64_t  batch     = 64;
+static int       tcp_port  = 30007;
+
+static
+double now_secs (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, & ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+// ****************************************************************
+// Stand-in simulator: serve n_instrs instructions, then exit
+
+static
+void sim_standin (const char *socket_name)
+{
+    uint64_t ptr = serv_socket_create (socket_name, tcp_port);
+    serv_socket_init (ptr);
+
+    uint8_t  instr [DII_BYTES];
+    uint8_t  trace [RVFI_BYTES];
+    uint64_t n_served = 0;
+    while (n_served < n_instrs) {
+	// Socket.bsv 'get' method, called every cycle
+	uint32_t x = 0;
+	int j;
+	for (j = 0; j < DII_BYTES; j++) {
+	    x = serv_socket_get8 (ptr);
+	    if (x == (uint32_t) -1) break;
+	    instr [j] = x;
+	}
+	if (j < DII_BYTES) continue;
+
+	// Socket.bsv 'put' method: a trace echoing the instruction
+	memset (trace, 0, RVFI_BYTES);
+	memcpy (trace, instr, DII_BYTES);
+	for (j = 0; j < RVFI_BYTES; j++)
+	    serv_socket_put8_blocking (ptr, trace [j]);
+	n_served++;
+    }
+    // Pending output is flushed at exit
+    exit (0);
+}
+
+// ****************************************************************
+// Stand-in test generator, over TCP or shared memory
+
+typedef struct {
+    int            sockfd;    // TCP
+    shm_client_t  *shm;       // shared memory
+} Client;
+
+static
+void client_push (Client *c, const uint8_t *p, size_t n)
+{
+    if (c->shm != NULL) {
+	shm_client_push_all (c->shm, p, n);
+	return;
+    }
+    while (n > 0) {
+	ssize_t k = send (c->sockfd, p, n, 0);
+	if (k <= 0) {
+	    perror ("send");
+	    exit (1);
+	}
+	p += k;
+	n -= k;
+    }
+}
+
+static
+void client_pull (Client *c, uint8_t *p, size_t n)
+{
+    if (c->shm != NULL) {
+	shm_client_pull_all (c->shm, p, n);
+	return;
+    }
+    while (n > 0) {
+	ssize_t k = recv (c->sockfd, p, n, 0);
+	if (k <= 0) {
+	    fprintf (stdout, "ERROR: connection closed by the simulator\n");
+	    exit (1);
+	}
+	p += k;
+	n -= k;
+    }
+}
+
+static
+void client_open (Client *c, const bool use_shm)
+{
+    c->sockfd = -1;
+    c->shm    = NULL;
+    if (use_shm) {
+	c->shm = shm_client_open (SHM_NAME, 5000);
+	if (c->shm == NULL)
+	    exit (1);
+	return;
+    }
+
+    struct sockaddr_in sa;
+    memset (& sa, 0, sizeof (sa));
+    sa.sin_family      = AF_INET;
+    sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    sa.sin_port        = htons (tcp_port);
+    // Retry while the simulator starts listening
+    for (int j = 0; j < 500; j++) {
+	c->sockfd = socket (AF_INET, SOCK_STREAM, 0);
+	if (connect (c->sockfd, (struct sockaddr *) & sa, sizeof (sa)) == 0) {
+	    int opt = 1;
+	    setsockopt (c->sockfd, IPPROTO_TCP, TCP_NODELAY, & opt, sizeof (opt));
+	    return;
+	}
+	close (c->sockfd);
+	usleep (10000);
+    }
+    perror ("connect");
+    exit (1);
+}
+
+static
+void client_close (Client *c)
+{
+    if (c->shm != NULL)
+	shm_client_close (c->shm);
+    else
+	close (c->sockfd);
+}
+
+// ****************************************************************
+// Run one transport; returns instructions/sec
+
+static
+double run (const bool use_shm)
+{
+    pid_t pid = fork ();
+    if (pid == 0)
+	sim_standin (use_shm ? ("shm:" SHM_NAME) : SOCKET_NAME);
+
+    Client c;
+    client_open (& c, use_shm);
+
+    uint8_t *instrs = (uint8_t *) malloc (batch * DII_BYTES);
+    uint8_t *traces = (uint8_t *) malloc (batch * RVFI_BYTES);
+
+    double   t0      = now_secs ();
+    uint64_t n_done  = 0;
+    bool     ok      = true;
+    while (n_done < n_instrs) {
+	uint64_t n = ((n_instrs - n_done) < batch) ? (n_instrs - n_done) : batch;
+	for (uint64_t j = 0; j < n; j++) {
+	    uint64_t seq = n_done + j;
+	    memcpy (& (instrs [j * DII_BYTES]), & seq, DII_BYTES);
+	}
+	client_push (& c, instrs, n * DII_BYTES);
+	client_pull (& c, traces, n * RVFI_BYTES);
+	for (uint64_t j = 0; j < n; j++) {
+	    uint64_t seq;
+	    memcpy (& seq, & (traces [j * RVFI_BYTES]), DII_BYTES);
+	    ok = ok && (seq == n_done + j);
+	}
+	n_done += n;
+    }
+    double secs = now_secs () - t0;
+
+    client_close (& c);
+    waitpid (pid, NULL, 0);
+    free (instrs);
+    free (traces);
+
+    if (! ok) {
+	fprintf (stdout, "ERROR: %s: traces out of order\n", use_shm ? "shm" : "tcp");
+	exit (1);
+    }
+    double rate = n_instrs / secs;
+    fprintf (stdout, "  %-4s %10" PRIu64 " instrs  %8.3f s  %12.0f instrs/s\n",
+	     use_shm ? "shm" : "tcp", n_instrs, secs, rate);
+    return rate;
+}
+
+// ****************************************************************
+
+static
+void print_usage (const char *argv0)
+{
+    fprintf (stdout, "Usage:\n");
+    fprintf (stdout, "  %s  [--transport tcp|shm|both] [--n <n>] [--batch <n>] [--port <n>]\n", argv0);
+    fprintf (stdout, "  --n      <n>  Instructions to run               (default %" PRIu64 ")\n", n_instrs);
+    fprintf (stdout, "  --batch  <n>  Instructions in flight            (default %" PRIu64 ")\n", batch);
+    fprintf (stdout, "  --port   <n>  TCP port                          (default %d)\n", tcp_port);
+}
+
+int main (int argc, char *argv [])
+{
+    const char *transport = "both";
+    for (int j = 1; j < argc; j++) {
+	if ((j + 1 < argc) && (strcmp (argv [j], "--transport") == 0))
+	    transport = argv [++j];
+	else if ((j + 1 < argc) && (strcmp (argv [j], "--n") == 0))
+	    n_instrs = strtoull (argv [++j], NULL, 0);
+	else if ((j + 1 < argc) && (strcmp (argv [j], "--batch") == 0))
+	    batch = strtoull (argv [++j], NULL, 0);
+	else if ((j + 1 < argc) && (strcmp (argv [j], "--port") == 0))
+	    tcp_port = atoi (argv [++j]);
+	else {
+	    print_usage (argv [0]);
+	    return ((strcmp (argv [j], "--help") == 0) ? 0 : 1);
+	}
+    }
+    if ((batch == 0) || (n_instrs == 0)) {
+	print_usage (argv [0]);
+	return 1;
+    }
+
+    // The stand-in simulator's own progress messages go to stdout too
+    setvbuf (stdout, NULL, _IONBF, 0);
+
+    // For the TCP stand-in simulator (socket_packet_utils reads <name>_PORT)
+    char port_str [16];
+    snprintf (port_str, sizeof (port_str), "%d", tcp_port);
+    setenv (SOCKET_NAME "_PORT", port_str, 1);
+
+    bool   do_tcp = (strcmp (transport, "shm") != 0);
+    bool   do_shm = (strcmp (transport, "tcp") != 0);
+    double r_tcp  = 0, r_shm = 0;
+
+    fprintf (stdout, "Batch of %" PRIu64 " instructions in flight\n", batch);
+    if (do_tcp) r_tcp = run (false);
+    if (do_shm) r_shm = run (true);
+    if (do_tcp && do_shm)
+	fprintf (stdout, "  shm/tcp speedup: %.1fx\n", r_shm / r_tcp);
+    return 0;
+}